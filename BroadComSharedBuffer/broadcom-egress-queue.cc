@@ -43,6 +43,11 @@ namespace ns3 {
 				DoubleValue(1000.0 * 1024 * 1024),
 				MakeDoubleAccessor(&BEgressQueue::m_maxBytes),
 				MakeDoubleChecker<double>())
+			.AddAttribute("Quantum",
+				"The default number of bytes a queue may send per DWRR round.",
+				UintegerValue(1500),
+				MakeUintegerAccessor(&BEgressQueue::m_defaultQuantum),
+				MakeUintegerChecker<uint32_t>(1))
 			;
 
 		return tid;
@@ -67,6 +72,12 @@ namespace ns3 {
 			m_minBW[i] = DataRate("10Gb/s");
 		}
 		m_minBW[3] = DataRate("10Gb/s");
+		for (uint32_t i = 0; i < qCnt; i++)
+		{
+			m_quantum[i] = 0; //0 means use the Quantum attribute
+			m_deficit[i] = 0;
+			m_dwrrActive[i] = false;
+		}
 	}
 
 	BEgressQueue::~BEgressQueue()
@@ -84,6 +95,7 @@ namespace ns3 {
 			m_queues[qIndex]->Enqueue(p);
 			m_bytesInQueueTotal += p->GetSize();
 			m_bytesInQueue[qIndex] += p->GetSize();
+			DwrrActivate(qIndex);
 		}
 		else
 		{
@@ -277,6 +289,87 @@ namespace ns3 {
 	}
 
 
+	Ptr<Packet>
+		BEgressQueue::DoDequeueDWRR(bool paused[]) //this is for switch only
+	{
+		NS_LOG_FUNCTION(this);
+
+		if (m_bytesInQueueTotal == 0)
+		{
+			NS_LOG_LOGIC("Queue empty");
+			return 0;
+		}
+
+		//same as Linux sch_drr: serve the head of the active list while its deficit covers
+		//the head packet, otherwise top it up with its quantum and move it to the tail
+		uint32_t skipped = 0;
+		while (!m_dwrrList.empty() && skipped < m_dwrrList.size())
+		{
+			uint32_t qIndex = m_dwrrList.front();
+			if (m_queues[qIndex]->GetNPackets() == 0)  //drained by another dequeue mode
+			{
+				m_dwrrList.pop_front();
+				m_dwrrActive[qIndex] = false;
+				continue;
+			}
+			if (paused[qIndex])  //keep the deficit for when it is resumed
+			{
+				m_dwrrList.pop_front();
+				m_dwrrList.push_back(qIndex);
+				skipped++;
+				continue;
+			}
+			skipped = 0;
+			uint32_t size = m_queues[qIndex]->Peek()->GetSize();
+			if (size > m_deficit[qIndex])
+			{
+				m_deficit[qIndex] += GetQuantum(qIndex);
+				m_dwrrList.pop_front();
+				m_dwrrList.push_back(qIndex);
+				continue;
+			}
+			Ptr<Packet> p = m_queues[qIndex]->Dequeue();
+			m_deficit[qIndex] -= size;
+			m_bytesInQueueTotal -= size;
+			m_bytesInQueue[qIndex] -= size;
+			if (m_queues[qIndex]->GetNPackets() == 0)
+			{
+				m_dwrrList.pop_front();
+				m_dwrrActive[qIndex] = false;
+			}
+			m_qlast = qIndex;
+			NS_LOG_LOGIC("Popped " << p);
+			NS_LOG_LOGIC("Number bytes " << m_bytesInQueueTotal);
+			return p;
+		}
+		NS_LOG_LOGIC("Nothing can be sent");
+		return 0;
+	}
+
+	void
+		BEgressQueue::DwrrActivate(uint32_t qIndex)
+	{
+		if (qIndex >= qCnt || m_dwrrActive[qIndex])
+			return;
+		m_dwrrActive[qIndex] = true;
+		m_deficit[qIndex] = GetQuantum(qIndex);
+		m_dwrrList.push_back(qIndex);
+	}
+
+	void
+		BEgressQueue::SetQuantum(uint32_t qIndex, uint32_t quantum)
+	{
+		NS_ASSERT(qIndex < qCnt);
+		m_quantum[qIndex] = quantum;
+	}
+
+	uint32_t
+		BEgressQueue::GetQuantum(uint32_t qIndex) const
+	{
+		NS_ASSERT(qIndex < qCnt);
+		return m_quantum[qIndex] ? m_quantum[qIndex] : m_defaultQuantum;
+	}
+
 	bool
 		BEgressQueue::Enqueue(Ptr<Packet> p, uint32_t qIndex)
 	{
@@ -371,6 +464,23 @@ namespace ns3 {
 
 
 
+	Ptr<Packet>
+		BEgressQueue::DequeueDWRR(bool paused[])
+	{
+		NS_LOG_FUNCTION(this);
+		Ptr<Packet> packet = DoDequeueDWRR(paused);
+		if (packet != 0)
+		{
+			NS_ASSERT(m_nBytes >= packet->GetSize());
+			NS_ASSERT(m_nPackets > 0);
+			m_nBytes -= packet->GetSize();
+			m_nPackets--;
+			NS_LOG_LOGIC("m_traceDequeue (packet)");
+			m_traceDequeue(packet);
+		}
+		return packet;
+	}
+
 	bool
 		BEgressQueue::DoEnqueue(Ptr<Packet> p)	//for compatiability
 	{
@@ -382,6 +492,7 @@ namespace ns3 {
 			m_queues[qIndex]->Enqueue(p);
 			m_bytesInQueueTotal += p->GetSize();
 			m_bytesInQueue[qIndex] += p->GetSize();
+			DwrrActivate(qIndex);
 		}
 		else
 		{
@@ -468,7 +579,6 @@ namespace ns3 {
 		BEgressQueue::RecoverQueue(Ptr<DropTailQueue> buffer, uint32_t i)
 	{
 		Ptr<Packet> packet;
-		Ptr<DropTailQueue> tmp = CreateObject<DropTailQueue>();
 		//clear orignial queue
 		while (!m_queues[i]->IsEmpty())
 		{
@@ -476,22 +586,111 @@ namespace ns3 {
 			m_bytesInQueue[i] -= packet->GetSize();
 			m_bytesInQueueTotal -= packet->GetSize();
 		}
-		//recover queue and preserve buffer
-		while (!buffer->IsEmpty())
+		//recover queue and preserve buffer: rotating the buffer once through its
+		//tail restores its order without a temporary queue. The queue gets copies,
+		//so the transmit path can add headers and tags without touching the buffer
+		uint32_t n = buffer->GetNPackets();
+		for (uint32_t k = 0; k < n; k++)
 		{
 			packet = buffer->Dequeue();
-			tmp->Enqueue(packet->Copy());
 			m_queues[i]->Enqueue(packet->Copy());
+			buffer->Enqueue(packet);
 			m_bytesInQueue[i] += packet->GetSize();
 			m_bytesInQueueTotal += packet->GetSize();
 		}
-		//restore buffer
-		while (!tmp->IsEmpty())
+		if (!m_queues[i]->IsEmpty())
 		{
-			buffer->Enqueue(tmp->Dequeue()->Copy());
+			DwrrActivate(i);
 		}
+	}
 
+	void
+		BEgressQueue::RecoverQueue(const BReplayRing &ring, uint32_t i)
+	{
+		Ptr<Packet> packet;
+		//clear orignial queue
+		while (!m_queues[i]->IsEmpty())
+		{
+			packet = m_queues[i]->Dequeue();
+			m_bytesInQueue[i] -= packet->GetSize();
+			m_bytesInQueueTotal -= packet->GetSize();
+		}
+		//replay the retained packets, the ring is left untouched
+		for (uint32_t k = 0; k < ring.GetNPackets(); k++)
+		{
+			m_queues[i]->Enqueue(ring.Get(k));
+		}
+		m_bytesInQueue[i] += ring.GetNBytes();
+		m_bytesInQueueTotal += ring.GetNBytes();
+		if (!m_queues[i]->IsEmpty())
+		{
+			DwrrActivate(i);
+		}
 	}
 
+	BReplayRing::BReplayRing() :
+		m_ring(16),
+		m_head(0),
+		m_count(0),
+		m_bytes(0)
+	{
+	}
+
+	void
+		BReplayRing::Push(Ptr<Packet> p)
+	{
+		if (m_count == m_ring.size())	//full, grow and unwrap
+		{
+			std::vector<Ptr<Packet> > ring(2 * m_ring.size());
+			for (uint32_t k = 0; k < m_count; k++)
+			{
+				ring[k] = m_ring[(m_head + k) % m_ring.size()];
+			}
+			m_ring.swap(ring);
+			m_head = 0;
+		}
+		m_ring[(m_head + m_count) % m_ring.size()] = p;
+		m_count++;
+		m_bytes += p->GetSize();
+	}
+
+	void
+		BReplayRing::Release(uint32_t n)
+	{
+		NS_ASSERT(n <= m_count);
+		for (uint32_t k = 0; k < n; k++)
+		{
+			m_bytes -= m_ring[m_head]->GetSize();
+			m_ring[m_head] = 0;
+			m_head = (m_head + 1) % m_ring.size();
+		}
+		m_count -= n;
+	}
+
+	void
+		BReplayRing::Clear()
+	{
+		Release(m_count);
+		m_head = 0;
+	}
+
+	Ptr<Packet>
+		BReplayRing::Get(uint32_t i) const
+	{
+		NS_ASSERT(i < m_count);
+		return m_ring[(m_head + i) % m_ring.size()];
+	}
+
+	uint32_t
+		BReplayRing::GetNPackets() const
+	{
+		return m_count;
+	}
+
+	uint32_t
+		BReplayRing::GetNBytes() const
+	{
+		return m_bytes;
+	}
 
 }
\ No newline at end of file
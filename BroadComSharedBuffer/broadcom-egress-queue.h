@@ -22,6 +22,8 @@
 #define BROADCOM_EGRESS_H
 
 #include <queue>
+#include <deque>
+#include <vector>
 #include "ns3/packet.h"
 #include "ns3/queue.h"
 #include "ns3/drop-tail-queue.h"
@@ -32,6 +34,32 @@ namespace ns3 {
 
 	class TraceContainer;
 
+	/**
+	 * Retransmission buffer for go-back-N recovery of a BEgressQueue queue.
+	 *
+	 * Sent packets are retained by reference in a ring until they are released
+	 * (acknowledged). RecoverQueue replays them from the oldest retained packet
+	 * without copying them and without draining the ring, so the same buffer can
+	 * be replayed again on the next recovery event. Replayed packets are shared
+	 * with the ring: Copy() a packet before modifying it.
+	 */
+	class BReplayRing {
+	public:
+		BReplayRing();
+		void Push(Ptr<Packet> p);
+		void Release(uint32_t n); //release the n oldest packets, e.g. when acked
+		void Clear();
+		Ptr<Packet> Get(uint32_t i) const; //i-th oldest retained packet
+		uint32_t GetNPackets() const;
+		uint32_t GetNBytes() const;
+
+	private:
+		std::vector<Ptr<Packet> > m_ring;
+		uint32_t m_head; //slot of the oldest retained packet
+		uint32_t m_count;
+		uint32_t m_bytes;
+	};
+
 	class BEgressQueue : public Queue {
 	public:
 		static TypeId GetTypeId(void);
@@ -44,11 +72,17 @@ namespace ns3 {
 		Ptr<Packet> DequeueRR(bool paused[]);
 		Ptr<Packet> DequeueNIC(bool paused[]);//QCN disable NIC
 		Ptr<Packet> DequeueQCN(bool paused[], Time avail[], uint32_t m_findex_qindex_map[]);//QCN enable NIC
+		Ptr<Packet> DequeueDWRR(bool paused[]);//deficit weighted round robin, for switch only
+		void SetQuantum(uint32_t qIndex, uint32_t quantum);
+		uint32_t GetQuantum(uint32_t qIndex) const;
 		uint32_t GetNBytes(uint32_t qIndex) const;
 		uint32_t GetNBytesTotal() const;
 		uint32_t GetLastQueue();
 		uint32_t m_fcount;
+		//replace queue i by copies of the packets of buffer, buffer keeps its packets and order
 		void RecoverQueue(Ptr<DropTailQueue> buffer, uint32_t i);
+		//replace queue i by the packets of ring, shared with it and not copied (see BReplayRing)
+		void RecoverQueue(const BReplayRing &ring, uint32_t i);
 
 	private:
 		bool DoEnqueue(Ptr<Packet> p, uint32_t qIndex);
@@ -56,6 +90,8 @@ namespace ns3 {
 		Ptr<Packet> DoDequeueNIC(bool paused[]);
 		Ptr<Packet> DoDequeueRR(bool paused[]);
 		Ptr<Packet> DoDequeueQCN(bool paused[], Time avail[], uint32_t m_findex_qindex_map[]);
+		Ptr<Packet> DoDequeueDWRR(bool paused[]);
+		void DwrrActivate(uint32_t qIndex);
 		//for compatibility
 		virtual bool DoEnqueue(Ptr<Packet> p);
 		virtual Ptr<Packet> DoDequeue(void);
@@ -75,6 +111,12 @@ namespace ns3 {
 		//For strict priority
 		Time m_bwsatisfied[qCnt];
 		DataRate m_minBW[qCnt];
+		//For DWRR
+		uint32_t m_defaultQuantum; //bytes added to a queue's deficit per round
+		uint32_t m_quantum[qCnt];
+		uint32_t m_deficit[qCnt];
+		bool m_dwrrActive[qCnt]; //true if the queue is in m_dwrrList
+		std::deque<uint32_t> m_dwrrList; //backlogged queues, head is served next
 	};
 
 } // namespace ns3
@@ -29,9 +29,11 @@
 #include "ns3/uinteger.h"
 #include "ns3/log.h"
 #include "ns3/assert.h"
+#include "ns3/abort.h"
 #include "ns3/global-value.h"
 #include "ns3/boolean.h"
 #include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
 #include "broadcom-node.h"
 #include "ns3/random-variable.h"
 
@@ -46,7 +48,10 @@ namespace ns3 {
 	{
 		static TypeId tid = TypeId("ns3::BroadcomNode")
 			.SetParent<Object>()
-			.AddConstructor<BroadcomNode>();
+			.AddConstructor<BroadcomNode>()
+			.AddTraceSource("Drop",
+				"A packet was refused by ingress or egress admission (port, qIndex, size, DropReason)",
+				MakeTraceSourceAccessor(&BroadcomNode::m_dropTrace));
 		return tid;
 	}
 
@@ -68,7 +73,10 @@ namespace ns3 {
 				m_usedEgressQSharedBytes[i][j] = 0;
 				m_pause_remote[i][j] = false;
 			}
+			m_pauseMask[i] = 0;
 		}
+		m_pausedPorts = 0;
+		ResetDropCounters();
 		for (int i = 0; i < 4; i++)
 		{
 			m_usedIngressSPBytes[i] = 0;
@@ -102,6 +110,7 @@ namespace ns3 {
 		m_dctcp_threshold = 40 * 1030;
 		m_dctcp_threshold_max = 400 * 1030;
 		m_pg_shared_alpha_cell = 16;
+		m_pg_shared_alpha_fp = (int64_t)(m_pg_shared_alpha_cell * (1 << alphaShift));
 		m_port_shared_alpha_cell = 128;   //not used for now. not sure whether this is used on switches
 		m_pg_shared_alpha_cell_off_diff = 16;
 		m_port_shared_alpha_cell_off_diff = 16;
@@ -114,12 +123,19 @@ namespace ns3 {
 	BroadcomNode::~BroadcomNode()
 	{}
 
+	void
+		BroadcomNode::DoDispose(void)
+	{
+		m_dropSnapshotEvent.Cancel();
+		Object::DoDispose();
+	}
+
 	bool
 		BroadcomNode::CheckIngressAdmission(uint32_t port, uint32_t qIndex, uint32_t psize)
 	{
 		if (m_usedTotalBytes + psize > m_maxBufferBytes)  //buffer full, usually should not reach here.
 		{
-			std::cout << "WARNING: Drop because ingress buffer full\n";
+			RecordDrop(port, qIndex, psize, DROP_INGRESS_BUFFER_FULL);
 			return false;
 		}
 		if (m_usedIngressPGBytes[port][qIndex] + psize > m_pg_min_cell && m_usedIngressPortBytes[port] + psize > m_port_min_cell) // exceed guaranteed, use share buffer
@@ -128,7 +144,8 @@ namespace ns3 {
 			{
 				if (m_usedIngressPGHeadroomBytes[port][qIndex] + psize > m_pg_hdrm_limit) // exceed headroom space
 				{
-					std::cout << "WARNING: Drop because ingress headroom full:" << m_usedIngressPGHeadroomBytes[port][qIndex] << "\t" << m_pg_hdrm_limit << "\n";
+					NS_LOG_LOGIC("Ingress headroom full: " << m_usedIngressPGHeadroomBytes[port][qIndex] << "\t" << m_pg_hdrm_limit);
+					RecordDrop(port, qIndex, psize, DROP_INGRESS_HEADROOM);
 					return false;
 				}
 			}
@@ -144,17 +161,17 @@ namespace ns3 {
 	{
 		if (m_usedEgressSPBytes[GetEgressSP(port, qIndex)] + psize > m_op_buffer_shared_limit_cell)  //exceed the sp limit
 		{
-			std::cout << "WARNING: Drop because egress SP buffer full\n";
+			RecordDrop(port, qIndex, psize, DROP_EGRESS_SP);
 			return false;
 		}
 		if (m_usedEgressPortBytes[port] + psize > m_op_uc_port_config_cell)	//exceed the port limit
 		{
-			std::cout << "WARNING: Drop because egress Port buffer full\n";
+			RecordDrop(port, qIndex, psize, DROP_EGRESS_PORT);
 			return false;
 		}
 		if (m_usedEgressQSharedBytes[port][qIndex] + psize > m_op_uc_port_config1_cell) //exceed the queue limit
 		{
-			std::cout << "WARNING: Drop because egress Q buffer full\n";
+			RecordDrop(port, qIndex, psize, DROP_EGRESS_QUEUE);
 			return false;
 		}
 		return true;
@@ -212,9 +229,49 @@ namespace ns3 {
 			m_usedIngressPGHeadroomBytes[port][qIndex] -= psize;
 		else
 			m_usedIngressPGHeadroomBytes[port][qIndex] = 0;
+
+		if (m_pausedPorts == 0)
+			return;
+		if (m_dynamicth)
+		{
+			// the SP occupancy dropped, which moves the threshold of every PG mapped to it
+			uint32_t sp = GetIngressSP(port, qIndex);
+			uint32_t spMask = 0;
+			for (uint32_t i = 0; i < qCnt; i++)
+			{
+				spMask |= (uint32_t)(GetIngressSP(port, i) == sp) << i;
+			}
+			uint64_t ports = m_pausedPorts;
+			while (ports)
+			{
+				uint32_t p = __builtin_ctzll(ports);
+				ports &= ports - 1;
+				CheckResume(p, m_pauseMask[p] & spMask);
+			}
+		}
+		else
+		{
+			CheckResume(port, m_pauseMask[port]);
+		}
 		return;
 	}
 
+	void
+		BroadcomNode::CheckResume(uint32_t port, uint32_t mask)
+	{
+		while (mask)
+		{
+			uint32_t q = __builtin_ctz(mask);
+			mask &= mask - 1;
+			if (GetResumeClasses(port, q))
+			{
+				ClearPauseMask(port, q);
+				if (!m_resumeCallback.IsNull())
+					m_resumeCallback(port, q);
+			}
+		}
+	}
+
 	void
 		BroadcomNode::RemoveFromEgressAdmission(uint32_t port, uint32_t qIndex, uint32_t psize)
 	{
@@ -241,53 +298,73 @@ namespace ns3 {
 	void
 		BroadcomNode::GetPauseClasses(uint32_t port, uint32_t qIndex, bool pClasses[])
 	{
+		uint32_t mask = GetPauseMask(port, qIndex);
+		for (uint32_t i = 0; i < qCnt; i++)
+		{
+			pClasses[i] = (mask >> i) & 1;
+		}
+		return;
+	}
+
+	uint32_t
+		BroadcomNode::GetPauseMask(uint32_t port, uint32_t qIndex)
+	{
+		uint32_t mask = 0;
 		if (m_dynamicth)
 		{
+			// pause PG i if used - guarantee > alpha * (sp limit - sp used), in fixed point.
+			// The right hand side is the same for all PGs, and the loop has no branches
+			// so the compiler can evaluate the 8 PGs with SIMD compares.
+			int64_t room = ((int64_t)m_buffer_cell_limit_sp - m_usedIngressSPBytes[GetIngressSP(port, qIndex)]) * m_pg_shared_alpha_fp;
+			int64_t guarantee = (int64_t)m_pg_min_cell + m_port_min_cell;
 			for (uint32_t i = 0; i < qCnt; i++)
 			{
-				pClasses[i] = false;
-				if (m_usedIngressPGBytes[port][i] <= m_pg_min_cell + m_port_min_cell)
-					continue;
-				if (i == 1 && !m_enable_pfc_on_dctcp)			//dctcp
-					continue;
-
-				if ((double)m_usedIngressPGBytes[port][i] - m_pg_min_cell - m_port_min_cell > m_pg_shared_alpha_cell*((double)m_buffer_cell_limit_sp - m_usedIngressSPBytes[GetIngressSP(port, qIndex)]))
-				{
-					pClasses[i] = true;
-				}
+				int64_t over = (int64_t)m_usedIngressPGBytes[port][i] - guarantee;
+				mask |= (uint32_t)((over > 0) & ((over << alphaShift) > room)) << i;
 			}
+			if (!m_enable_pfc_on_dctcp)			//dctcp
+				mask &= ~(1u << 1);
 		}
 		else
 		{
 			if (m_usedIngressPortBytes[port] > m_port_max_shared_cell)					//pause the whole port
 			{
-				for (uint32_t i = 0; i < qCnt; i++)
-				{
-					if (i == 1 && !m_enable_pfc_on_dctcp)	//dctcp
-						pClasses[i] = false;
-
-					pClasses[i] = true;
-				}
-				return;
-			}
-			else
-			{
-				for (uint32_t i = 0; i < qCnt; i++)
-				{
-					pClasses[i] = false;
-				}
+				return (1u << qCnt) - 1;
 			}
 			if (m_usedIngressPGBytes[port][qIndex] > m_pg_shared_limit_cell)
 			{
 				if (qIndex == 1 && !m_enable_pfc_on_dctcp)
-					return;
+					return 0;
 
-				pClasses[qIndex] = true;
+				mask = 1u << qIndex;
 			}
 		}
-		return;
+		return mask;
 	}
 
+	uint32_t
+		BroadcomNode::UpdatePauseMask(uint32_t port, uint32_t qIndex)
+	{
+		uint32_t changed = GetPauseMask(port, qIndex) & ~m_pauseMask[port];
+		m_pauseMask[port] |= changed;
+		if (changed)
+			m_pausedPorts |= (uint64_t)1 << port;
+		return changed;
+	}
+
+	void
+		BroadcomNode::ClearPauseMask(uint32_t port, uint32_t qIndex)
+	{
+		m_pauseMask[port] &= ~(1u << qIndex);
+		if (m_pauseMask[port] == 0)
+			m_pausedPorts &= ~((uint64_t)1 << port);
+	}
+
+	void
+		BroadcomNode::SetResumeCallback(Callback<void, uint32_t, uint32_t> cb)
+	{
+		m_resumeCallback = cb;
+	}
 
 	bool
 		BroadcomNode::GetResumeClasses(uint32_t port, uint32_t qIndex)
@@ -310,6 +387,105 @@ namespace ns3 {
 		return false;
 	}
 
+	void
+		BroadcomNode::RecordDrop(uint32_t port, uint32_t qIndex, uint32_t psize, DropReason reason)
+	{
+		NS_LOG_LOGIC("Drop on port " << port << " queue " << qIndex << ": " << GetDropReasonName(reason));
+		m_dropCount[port][reason]++;
+		m_dropTrace(port, qIndex, psize, reason);
+	}
+
+	const char*
+		BroadcomNode::GetDropReasonName(DropReason reason)
+	{
+		switch (reason)
+		{
+		case DROP_INGRESS_BUFFER_FULL:
+			return "IngressBufferFull";
+		case DROP_INGRESS_HEADROOM:
+			return "IngressHeadroom";
+		case DROP_EGRESS_SP:
+			return "EgressSP";
+		case DROP_EGRESS_PORT:
+			return "EgressPort";
+		case DROP_EGRESS_QUEUE:
+			return "EgressQueue";
+		default:
+			return "Unknown";
+		}
+	}
+
+	uint64_t
+		BroadcomNode::GetDropCount(uint32_t port, DropReason reason) const
+	{
+		return m_dropCount[port][reason];
+	}
+
+	uint64_t
+		BroadcomNode::GetTotalDropCount(DropReason reason) const
+	{
+		uint64_t total = 0;
+		for (uint32_t i = 0; i < pCnt; i++)
+		{
+			total += m_dropCount[i][reason];
+		}
+		return total;
+	}
+
+	void
+		BroadcomNode::ResetDropCounters()
+	{
+		for (uint32_t i = 0; i < pCnt; i++)
+		{
+			for (uint32_t j = 0; j < DROP_REASON_COUNT; j++)
+			{
+				m_dropCount[i][j] = 0;
+			}
+		}
+	}
+
+	void
+		BroadcomNode::PrintDropCounters(std::ostream &os) const
+	{
+		for (uint32_t i = 0; i < pCnt; i++)
+		{
+			uint64_t sum = 0;
+			for (uint32_t j = 0; j < DROP_REASON_COUNT; j++)
+			{
+				sum += m_dropCount[i][j];
+			}
+			if (sum == 0)
+				continue;
+			os << Simulator::Now().GetSeconds() << "\tport " << i;
+			for (uint32_t j = 0; j < DROP_REASON_COUNT; j++)
+			{
+				os << "\t" << GetDropReasonName((DropReason)j) << " " << m_dropCount[i][j];
+			}
+			os << "\n";
+		}
+	}
+
+	void
+		BroadcomNode::ScheduleDropSnapshot(Time interval, std::ostream *os)
+	{
+		NS_ABORT_MSG_IF(!interval.IsStrictlyPositive(), "The drop snapshot interval has to be positive");
+		m_dropSnapshotEvent.Cancel();
+		m_dropSnapshotEvent = Simulator::ScheduleNow(&BroadcomNode::DropSnapshot, this, interval, os);
+	}
+
+	void
+		BroadcomNode::StopDropSnapshot()
+	{
+		m_dropSnapshotEvent.Cancel();
+	}
+
+	void
+		BroadcomNode::DropSnapshot(Time interval, std::ostream *os)
+	{
+		PrintDropCounters(*os);
+		m_dropSnapshotEvent = Simulator::Schedule(interval, &BroadcomNode::DropSnapshot, this, interval, os);
+	}
+
 	uint32_t
 		BroadcomNode::GetIngressSP(uint32_t port, uint32_t pgIndex)
 	{
@@ -398,6 +574,7 @@ namespace ns3 {
 		m_op_uc_port_config_cell = op_uc_port_config_cell;
 		m_op_buffer_shared_limit_cell = op_buffer_shared_limit_cell;
 		m_pg_shared_alpha_cell = q_shared_alpha_cell;
+		m_pg_shared_alpha_fp = (int64_t)q_shared_alpha_cell << alphaShift;
 		m_port_shared_alpha_cell = port_share_alpha_cell;
 		m_pg_qcn_threshold = pg_qcn_threshold;
 	}
@@ -21,11 +21,15 @@
 #define BROADCOM_NODE_H
 
 #include <vector>
+#include <ostream>
 
 #include "ns3/object.h"
 #include "ns3/callback.h"
 #include "ns3/ptr.h"
 #include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
 
 namespace ns3 {
 
@@ -58,6 +62,16 @@ namespace ns3 {
 		static const unsigned qCnt = 8;	// Number of queues/priorities used
 		static const unsigned pCnt = 64;	// Number of ports used
 
+		enum DropReason
+		{
+			DROP_INGRESS_BUFFER_FULL = 0,	// total buffer exhausted
+			DROP_INGRESS_HEADROOM,	// PG headroom exhausted
+			DROP_EGRESS_SP,	// egress service pool limit
+			DROP_EGRESS_PORT,	// egress port limit
+			DROP_EGRESS_QUEUE,	// egress queue limit
+			DROP_REASON_COUNT
+		};
+
 		static TypeId GetTypeId(void);
 
 		BroadcomNode();
@@ -80,6 +94,21 @@ namespace ns3 {
 		void GetPauseClasses(uint32_t port, uint32_t qIndex, bool pClasses[]);
 		bool GetResumeClasses(uint32_t port, uint32_t qIndex);
 
+		// bit i set = PG i of the port is over its pause threshold
+		uint32_t GetPauseMask(uint32_t port, uint32_t qIndex);
+		// PGs that crossed their pause threshold since the last call and were not
+		// paused yet; they are recorded as paused, so a PAUSE is only sent on change
+		uint32_t UpdatePauseMask(uint32_t port, uint32_t qIndex);
+		// the RESUME for the PG has been sent
+		void ClearPauseMask(uint32_t port, uint32_t qIndex);
+
+		/**
+		 * Called with (port, qIndex) when a paused PG drains below its resume
+		 * threshold. RemoveFromIngressAdmission checks the paused PGs only, so
+		 * the device does not need to poll GetResumeClasses.
+		 */
+		void SetResumeCallback(Callback<void, uint32_t, uint32_t> cb);
+
 		void SetBroadcomParams(
 			uint32_t buffer_cell_limit_sp, //ingress sp buffer threshold p.120
 			uint32_t buffer_cell_limit_sp_shared, //ingress sp buffer shared threshold, nonshare -> share
@@ -109,7 +138,19 @@ namespace ns3 {
 
 		void SetDynamicThreshold();
 
+		// drop accounting, replaces the old per-drop warnings on stdout
+		static const char* GetDropReasonName(DropReason reason);
+		uint64_t GetDropCount(uint32_t port, DropReason reason) const;
+		uint64_t GetTotalDropCount(DropReason reason) const;
+		void ResetDropCounters();
+		// one line per port that has drops: port and the count of every reason
+		void PrintDropCounters(std::ostream &os) const;
+		// print the counters every interval, starting now, until StopDropSnapshot or disposal
+		void ScheduleDropSnapshot(Time interval, std::ostream *os);
+		void StopDropSnapshot();
+
 	protected:
+		virtual void DoDispose(void);
 		uint32_t GetIngressSP(uint32_t port, uint32_t pgIndex);
 		uint32_t GetEgressSP(uint32_t port, uint32_t qIndex);
 
@@ -157,6 +198,19 @@ namespace ns3 {
 		double m_port_shared_alpha_cell;
 		double m_port_shared_alpha_cell_off_diff;
 		bool m_dynamicth;
+		static const unsigned alphaShift = 16;	// fixed-point fraction bits of the alphas
+		int64_t m_pg_shared_alpha_fp;	// m_pg_shared_alpha_cell << alphaShift
+
+		uint32_t m_pauseMask[pCnt];	// PGs we have sent a PAUSE for, per port
+		uint64_t m_pausedPorts;	// bit p set = m_pauseMask[p] != 0
+		Callback<void, uint32_t, uint32_t> m_resumeCallback;
+		void CheckResume(uint32_t port, uint32_t mask);
+
+		uint64_t m_dropCount[pCnt][DROP_REASON_COUNT];
+		TracedCallback<uint32_t, uint32_t, uint32_t, uint32_t> m_dropTrace;	// port, qIndex, psize, reason
+		void RecordDrop(uint32_t port, uint32_t qIndex, uint32_t psize, DropReason reason);
+		void DropSnapshot(Time interval, std::ostream *os);
+		EventId m_dropSnapshotEvent;
 
 		//QCN threshold
 		uint32_t m_pg_qcn_threshold;
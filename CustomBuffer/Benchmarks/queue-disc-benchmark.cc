@@ -0,0 +1,241 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Microbenchmark of the DT/FB queue disc hot paths, outside of a simulation.
+//
+// The queue discs are created and driven directly with a synthetic stream of
+// Ipv4QueueDiscItems: a pool of packets with a configurable share of high
+// priority (MyTag 0) packets and uniform random sizes, generated once so the
+// timed loops do not allocate. Reported, in ns per operation:
+//  - enqueue: Enqueue at the given occupancy, admitted or dropped by the
+//    threshold, the share of admitted packets is printed too;
+//  - dequeue: Dequeue of the packets admitted by the previous batch, so the
+//    occupancy stays around its target;
+//  - threshold: GetQueueThreshold alone, both classes in turn;
+//  - drop: Enqueue of low priority packets into a queue filled past the low
+//    priority threshold, so every one of them goes through DropBeforeEnqueue.
+//
+// The queue discs are the ones of ../Fabric, built here through the
+// fabric-*.cc files, one per source since every source defines its own log
+// component. BEgressQueue (BroadComSharedBuffer) is written against
+// the ns-3.17 API and can not be linked here.
+//
+//  ./ns3 run "CustomBuffer/Benchmarks/queue-disc-benchmark --nOps=1000000 --highFraction=0.2"
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "../Fabric/queue-disc.h"
+#include "../Fabric/customTag.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("QueueDiscBenchmark");
+
+struct BenchmarkConfig
+{
+  uint64_t nOps;
+  uint32_t queueSize;      //!< [packets]
+  double occupancy;        //!< target occupancy, share of queueSize
+  double highFraction;     //!< share of high priority packets
+  uint32_t minSize;        //!< [bytes]
+  uint32_t maxSize;        //!< [bytes]
+  uint32_t batch;
+  uint32_t seed;
+};
+
+static std::vector<Ptr<QueueDiscItem>>
+MakeItems (uint32_t n, double highFraction, uint32_t minSize, uint32_t maxSize, std::mt19937 &rng)
+{
+  std::uniform_real_distribution<double> u (0, 1);
+  std::uniform_int_distribution<uint32_t> size (minSize, maxSize);
+  std::vector<Ptr<QueueDiscItem>> items;
+  items.reserve (n);
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Ptr<Packet> p = Create<Packet> (size (rng));
+      MyTag flowPrioTag;
+      flowPrioTag.SetSimpleValue (u (rng) < highFraction ? 0x0 : 0x1);
+      p->AddPacketTag (flowPrioTag);
+      Ipv4Header header;
+      header.SetPayloadSize (p->GetSize ());
+      items.push_back (Create<Ipv4QueueDiscItem> (p, Address (), Ipv4L3Protocol::PROT_NUMBER, header));
+    }
+  return items;
+}
+
+static double
+ElapsedNs (std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+}
+
+static void
+RunBenchmark (const std::string &type, const BenchmarkConfig &config)
+{
+  ObjectFactory factory;
+  factory.SetTypeId ("ns3::" + type);
+  factory.Set ("MaxSize", QueueSizeValue (QueueSize (QueueSizeUnit::PACKETS, config.queueSize)));
+  Ptr<QueueDisc> qd = factory.Create<QueueDisc> ();
+  qd->Initialize ();
+
+  std::mt19937 rng (config.seed);
+  // more items than can be in the queue, so an item is never enqueued twice
+  uint32_t poolSize = 2 * config.queueSize + 2 * config.batch;
+  std::vector<Ptr<QueueDiscItem>> items = MakeItems (poolSize, config.highFraction,
+                                                     config.minSize, config.maxSize, rng);
+  std::vector<Ptr<QueueDiscItem>> lowItems = MakeItems (poolSize, 0, config.minSize, config.maxSize, rng);
+  std::vector<Ptr<QueueDiscItem>> highItems = MakeItems (poolSize, 1, config.minSize, config.maxSize, rng);
+  uint32_t next = 0;
+
+  // fill up to the target occupancy, or as far as the thresholds allow
+  uint32_t target = static_cast<uint32_t> (config.occupancy * config.queueSize);
+  uint32_t failures = 0;
+  while (qd->GetNPackets () < target && failures < poolSize)
+    {
+      failures += qd->Enqueue (items[next++ % poolSize]) ? 0 : 1;
+    }
+
+  // steady state enqueue/dequeue around the occupancy
+  double enqueueNs = 0;
+  double dequeueNs = 0;
+  uint64_t enqueued = 0;
+  uint64_t accepted = 0;
+  uint64_t dequeued = 0;
+  while (enqueued < config.nOps)
+    {
+      uint32_t batchAccepted = 0;
+      auto start = std::chrono::steady_clock::now ();
+      for (uint32_t b = 0; b < config.batch; ++b)
+        {
+          batchAccepted += qd->Enqueue (items[next++ % poolSize]) ? 1 : 0;
+        }
+      enqueueNs += ElapsedNs (start);
+      enqueued += config.batch;
+      accepted += batchAccepted;
+
+      start = std::chrono::steady_clock::now ();
+      for (uint32_t b = 0; b < batchAccepted; ++b)
+        {
+          qd->Dequeue ();
+        }
+      dequeueNs += ElapsedNs (start);
+      dequeued += batchAccepted;
+    }
+  uint32_t occupancy = qd->GetNPackets ();
+
+  // the threshold alone, at the steady state occupancy
+  uint32_t alphaHigh = QueueDisc::AlphaToFixedPoint (2);
+  uint32_t alphaLow = QueueDisc::AlphaToFixedPoint (1);
+  uint64_t thresholdSum = 0;
+  auto start = std::chrono::steady_clock::now ();
+  for (uint64_t i = 0; i < config.nOps; i += 2)
+    {
+      thresholdSum += qd->GetQueueThreshold (0, alphaHigh).GetValue ();
+      thresholdSum += qd->GetQueueThreshold (1, alphaLow).GetValue ();
+    }
+  double thresholdNs = ElapsedNs (start);
+
+  // drop path: high priority packets fill the queue past the low priority
+  // threshold, then every low priority packet is dropped
+  while (qd->Dequeue ())
+    {
+    }
+  next = 0;
+  failures = 0;
+  while (failures < config.batch && next < poolSize)
+    {
+      failures += qd->Enqueue (highItems[next++]) ? 0 : 1;
+    }
+  uint32_t dropsBefore = qd->GetStats ().nTotalDroppedPacketsBeforeEnqueue;
+  next = 0;
+  start = std::chrono::steady_clock::now ();
+  for (uint64_t i = 0; i < config.nOps; ++i)
+    {
+      qd->Enqueue (lowItems[next++ % poolSize]);
+    }
+  double dropNs = ElapsedNs (start);
+  uint64_t drops = qd->GetStats ().nTotalDroppedPacketsBeforeEnqueue - dropsBefore;
+
+  std::cout << type << std::endl;
+  std::cout << "  " << type << " occupancy:   " << occupancy << " packets" << std::endl;
+  std::cout << "  " << type << " enqueue:   " << enqueueNs / enqueued << " ns/op ("
+            << 100.0 * accepted / enqueued << "% admitted)" << std::endl;
+  std::cout << "  " << type << " dequeue:   " << (dequeued ? dequeueNs / dequeued : 0) << " ns/op" << std::endl;
+  std::cout << "  " << type << " threshold:   " << thresholdNs / config.nOps << " ns/op"
+            << " (checksum " << thresholdSum % 1000 << ")" << std::endl;
+  std::cout << "  " << type << " drop:   " << dropNs / config.nOps << " ns/op ("
+            << 100.0 * drops / config.nOps << "% dropped)" << std::endl;
+
+  qd->Dispose ();
+}
+
+int main (int argc, char *argv[])
+{
+  BenchmarkConfig config;
+  config.nOps = 1000000;
+  config.queueSize = 1000;
+  config.occupancy = 0.3;
+  config.highFraction = 0.5;
+  config.minSize = 64;
+  config.maxSize = 1500;
+  config.batch = 32;
+  config.seed = 1;
+  std::string queueDiscs = "DT_FifoQueueDisc_v02,FB_FifoQueueDisc_v01";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("nOps", "Number of operations per measurement", config.nOps);
+  cmd.AddValue ("queueSize", "The queue disc size [packets]", config.queueSize);
+  cmd.AddValue ("occupancy", "Target occupancy of the enqueue/dequeue loop, share of queueSize", config.occupancy);
+  cmd.AddValue ("highFraction", "Share of high priority packets", config.highFraction);
+  cmd.AddValue ("minSize", "Smallest packet [bytes]", config.minSize);
+  cmd.AddValue ("maxSize", "Largest packet [bytes]", config.maxSize);
+  cmd.AddValue ("batch", "Packets per timed batch", config.batch);
+  cmd.AddValue ("seed", "Seed of the packet stream", config.seed);
+  cmd.AddValue ("queueDiscs", "Comma separated queue disc types", queueDiscs);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (config.minSize > config.maxSize, "minSize > maxSize");
+  NS_ABORT_MSG_IF (config.batch == 0, "batch must not be 0");
+
+  std::cout << std::endl << "*** Queue disc microbenchmark ***" << std::endl;
+  std::cout << "  Queue size:   " << config.queueSize << " packets" << std::endl;
+  std::cout << "  Target occupancy:   " << config.occupancy << std::endl;
+  std::cout << "  High priority fraction:   " << config.highFraction << std::endl;
+  std::cout << "  Packet sizes:   " << config.minSize << " - " << config.maxSize << " bytes" << std::endl;
+
+  std::string::size_type begin = 0;
+  while (begin < queueDiscs.size ())
+    {
+      std::string::size_type end = queueDiscs.find (',', begin);
+      if (end == std::string::npos)
+        {
+          end = queueDiscs.size ();
+        }
+      RunBenchmark (queueDiscs.substr (begin, end - begin), config);
+      begin = end + 1;
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -23,6 +23,7 @@
 #include "ns3/object-factory.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/socket.h"
+#include "ns3/double.h"
 #include "customTag.h"
 
 namespace ns3 {
@@ -43,6 +44,16 @@ TypeId DT_FifoQueueDisc_v02::GetTypeId (void)
                    MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
                                           &QueueDisc::GetMaxSize),
                    MakeQueueSizeChecker ())
+    .AddAttribute ("AlphaHigh",
+                   "The alpha of the high priority packets",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&DT_FifoQueueDisc_v02::m_alpha_h),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("AlphaLow",
+                   "The alpha of the low priority packets",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&DT_FifoQueueDisc_v02::m_alpha_l),
+                   MakeDoubleChecker<double> (0))
   ;
   return tid;
 }
@@ -63,9 +74,7 @@ DT_FifoQueueDisc_v02::DoEnqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
   
-  int alpha_l = 1;
-  int alpha_h = 2;
-  int alpha;
+  uint32_t alphaFp;
 
  ///////////////////////////////////////////////////////// 
   // set a besic Packet clasification based on arbitrary Tag from recieved packet:
@@ -79,11 +88,11 @@ DT_FifoQueueDisc_v02::DoEnqueue (Ptr<QueueDiscItem> item)
   
   if (flow_priority == 0)
     {
-      alpha = alpha_h;
+      alphaFp = m_alphaFp_h;
     }
   else
     {
-      alpha = alpha_l;
+      alphaFp = m_alphaFp_l;
     }
 /////////////////////////////////////////////////////////
 
@@ -113,7 +122,7 @@ DT_FifoQueueDisc_v02::DoEnqueue (Ptr<QueueDiscItem> item)
 
 
   // if (GetCurrentSize () + item > GetMaxSize ())
-  if ((GetCurrentSize () + item > GetQueueThreshold(alpha, alpha_l, alpha_h)) or (GetCurrentSize () + item > GetMaxSize ()))
+  if ((GetCurrentSize () + item > GetQueueThreshold (flow_priority, alphaFp)) or (GetCurrentSize () + item > GetMaxSize ()))
     {
       // NS_LOG_LOGIC ("Queue full -- dropping pkt");
       NS_LOG_LOGIC ("Queue exceeds threshold -- dropping pkt");
@@ -128,7 +137,7 @@ DT_FifoQueueDisc_v02::DoEnqueue (Ptr<QueueDiscItem> item)
 
   NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
   NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
-  NS_LOG_LOGIC ("Enqueue Threshold " << GetQueueThreshold (alpha, alpha_l, alpha_h));
+  NS_LOG_LOGIC ("Enqueue Threshold " << GetQueueThreshold (flow_priority, alphaFp));
 
   return retval;
 }
@@ -201,6 +210,9 @@ void
 DT_FifoQueueDisc_v02::InitializeParams (void)
 {
   NS_LOG_FUNCTION (this);
+  // the enqueue path only uses the fixed point values
+  m_alphaFp_h = AlphaToFixedPoint (m_alpha_h);
+  m_alphaFp_l = AlphaToFixedPoint (m_alpha_l);
 }
 
 } // namespace ns3
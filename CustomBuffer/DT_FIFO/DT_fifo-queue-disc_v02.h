@@ -57,6 +57,11 @@ private:
   virtual Ptr<const QueueDiscItem> DoPeek (void);
   virtual bool CheckConfig (void);
   virtual void InitializeParams (void);
+
+  double m_alpha_h;        //!< alpha of the high priority packets
+  double m_alpha_l;        //!< alpha of the low priority packets
+  uint32_t m_alphaFp_h;    //!< m_alpha_h in fixed point, set by InitializeParams
+  uint32_t m_alphaFp_l;    //!< m_alpha_l in fixed point, set by InitializeParams
 };
 
 } // namespace ns3
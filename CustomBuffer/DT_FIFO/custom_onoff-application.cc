@@ -101,6 +101,12 @@ CustomOnOffApplication::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&CustomOnOffApplication::m_enableSeqTsSizeHeader),
                    MakeBooleanChecker ())
+    .AddAttribute ("MiceThreshold",
+                   "The number of packets at the start of every On period "
+                   "that are sent with high priority (mice)",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&CustomOnOffApplication::m_miceThreshold),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("Tx", "A new packet is created and is sent",
                      MakeTraceSourceAccessor (&CustomOnOffApplication::m_txTrace),
                      "ns3::Packet::TracedCallback")
@@ -153,6 +159,26 @@ CustomOnOffApplication::SetMaxBytes (uint64_t maxBytes)
   m_maxBytes = maxBytes;
 }
 
+uint64_t
+CustomOnOffApplication::GetTotalBytes (void) const
+{
+  return m_totBytes;
+}
+
+uint64_t
+CustomOnOffApplication::GetPacketsSent (void) const
+{
+  return m_packetsSent;
+}
+
+void
+CustomOnOffApplication::SetSentCounters (uint64_t totBytes, uint64_t packetsSent)
+{
+  NS_LOG_FUNCTION (this << totBytes << packetsSent);
+  m_totBytes = totBytes;
+  m_packetsSent = packetsSent;
+}
+
 // Ptr<Socket>
 // CustomOnOffApplication::GetSocket (void) const
 // {
@@ -334,12 +360,11 @@ void CustomOnOffApplication::SendPacket ()
   // create a tag.
   MyTag flowPrioTag;
   // set Tag value to depend on the number of previously sent packets
-  // if m_packetSeqCount < Threshold: TagValue->0x0 (High Priority)
-  // if m_packetSeqCount >= Threshold: TagValue->0x1 (Low Priority)
+  // if m_packetSeqCount < m_miceThreshold: TagValue->0x0 (High Priority)
+  // if m_packetSeqCount >= m_miceThreshold: TagValue->0x1 (Low Priority)
   
-  uint8_t Threshold = 10; // [packets], max number of packets per flow to be considered mouse flow
-
-  if (m_packetSeqCount < Threshold)
+  // m_miceThreshold [packets], max number of packets per flow to be considered mouse flow
+  if (m_packetSeqCount < m_miceThreshold)
   {
     flowPrioTag.SetSimpleValue (0x0);
   }
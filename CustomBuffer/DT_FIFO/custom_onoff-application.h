@@ -128,6 +128,22 @@ public:
    */
   void SetMaxBytes (uint64_t maxBytes);
 
+  /// \return the total number of bytes sent so far
+  uint64_t GetTotalBytes (void) const;
+  /// \return the total number of packets sent so far
+  uint64_t GetPacketsSent (void) const;
+
+  /**
+   * \brief Continue from the counters saved by a checkpoint.
+   *
+   * Call before the application starts; MaxBytes then also counts the bytes
+   * sent before the checkpoint.
+   *
+   * \param totBytes the bytes sent before the checkpoint
+   * \param packetsSent the packets sent before the checkpoint
+   */
+  void SetSentCounters (uint64_t totBytes, uint64_t packetsSent);
+
   /**
    * \brief Return a pointer to associated socket.
    * \return pointer to associated socket
@@ -186,6 +202,7 @@ private:
   uint64_t        m_totBytes;     //!< Total bytes sent so far
   uint64_t        m_packetsSent;   //!< Total packets sent so far, added by me
   uint64_t        m_packetSeqCount; //!< Number of packets sent in sequence, added by me
+  uint32_t        m_miceThreshold; //!< Packets per sequence sent with high priority
   EventId         m_startStopEvent;     //!< Event id for next start or stop event
   EventId         m_sendEvent;    //!< Event id of pending "send packet" event
   TypeId          m_tid;          //!< Type of the socket used
@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "flow-stats-collector.h"
+#include "customTag.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowStatsCollector");
+
+/**
+ * The time a packet was sent by its source, set by FlowStatsCollector.
+ */
+class FlowStatsTimestampTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::FlowStatsTimestampTag")
+      .SetParent<Tag> ()
+      .AddConstructor<FlowStatsTimestampTag> ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 8;
+  }
+  virtual void Serialize (TagBuffer i) const
+  {
+    i.WriteU64 (m_txTime);
+  }
+  virtual void Deserialize (TagBuffer i)
+  {
+    m_txTime = i.ReadU64 ();
+  }
+  virtual void Print (std::ostream &os) const
+  {
+    os << "txTime=" << m_txTime << "ns";
+  }
+
+  uint64_t m_txTime {0};   //!< [ns]
+};
+
+NS_OBJECT_ENSURE_REGISTERED (FlowStatsTimestampTag);
+
+QuantileSketch::QuantileSketch ()
+{
+  Reset ();
+}
+
+void
+QuantileSketch::Reset (void)
+{
+  m_counts.fill (0);
+  m_count = 0;
+  m_min = std::numeric_limits<uint64_t>::max ();
+  m_max = 0;
+  m_sum = 0;
+}
+
+uint32_t
+QuantileSketch::GetBucket (uint64_t value)
+{
+  if (value < SUB_BUCKETS)
+    {
+      return value;
+    }
+  uint32_t exponent = 63 - __builtin_clzll (value);
+  uint32_t sub = (value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+  return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t
+QuantileSketch::GetBucketMiddle (uint32_t bucket)
+{
+  if (bucket < SUB_BUCKETS)
+    {
+      return bucket;
+    }
+  uint32_t shift = bucket / SUB_BUCKETS - 1;
+  uint64_t lower = static_cast<uint64_t> (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  return lower + ((1ULL << shift) >> 1);
+}
+
+void
+QuantileSketch::Add (uint64_t value)
+{
+  m_counts[GetBucket (value)]++;
+  m_count++;
+  m_min = std::min (m_min, value);
+  m_max = std::max (m_max, value);
+  m_sum += value;
+}
+
+void
+QuantileSketch::Merge (const QuantileSketch &other)
+{
+  for (uint32_t i = 0; i < N_BUCKETS; ++i)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+  m_count += other.m_count;
+  m_min = std::min (m_min, other.m_min);
+  m_max = std::max (m_max, other.m_max);
+  m_sum += other.m_sum;
+}
+
+uint64_t
+QuantileSketch::GetCount (void) const
+{
+  return m_count;
+}
+
+uint64_t
+QuantileSketch::GetMin (void) const
+{
+  return m_count ? m_min : 0;
+}
+
+uint64_t
+QuantileSketch::GetMax (void) const
+{
+  return m_max;
+}
+
+double
+QuantileSketch::GetMean (void) const
+{
+  return m_count ? m_sum / m_count : 0;
+}
+
+uint64_t
+QuantileSketch::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  // rank of the quantile, 1 based
+  uint64_t rank = std::max<uint64_t> (1, static_cast<uint64_t> (q * m_count + 0.5));
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < N_BUCKETS; ++i)
+    {
+      seen += m_counts[i];
+      if (seen >= rank)
+        {
+          return std::min (std::max (GetBucketMiddle (i), m_min), m_max);
+        }
+    }
+  return m_max;
+}
+
+FlowStatsCollector::FlowStatsCollector ()
+  : m_miceBytes (100000)
+{
+}
+
+void
+FlowStatsCollector::SetMiceBytes (uint64_t miceBytes)
+{
+  m_miceBytes = miceBytes;
+}
+
+void
+FlowStatsCollector::InstallSenders (NodeContainer senders)
+{
+  for (uint32_t i = 0; i < senders.GetN (); ++i)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = senders.Get (i)->GetObject<Ipv4L3Protocol> ();
+      NS_ABORT_MSG_IF (!ipv4, "Install the internet stack before the FlowStatsCollector");
+      ipv4->TraceConnectWithoutContext ("SendOutgoing", MakeCallback (&FlowStatsCollector::Stamp, this));
+    }
+}
+
+void
+FlowStatsCollector::InstallReceivers (NodeContainer receivers)
+{
+  for (uint32_t i = 0; i < receivers.GetN (); ++i)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = receivers.Get (i)->GetObject<Ipv4L3Protocol> ();
+      NS_ABORT_MSG_IF (!ipv4, "Install the internet stack before the FlowStatsCollector");
+      ipv4->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&FlowStatsCollector::Deliver, this));
+    }
+}
+
+void
+FlowStatsCollector::Stamp (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  FlowStatsTimestampTag tag;
+  if (packet->PeekPacketTag (tag))
+    {
+      return;
+    }
+  tag.m_txTime = Simulator::Now ().GetNanoSeconds ();
+  packet->AddPacketTag (tag);
+}
+
+void
+FlowStatsCollector::Deliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface)
+{
+  FlowStatsTimestampTag tag;
+  if (!packet->PeekPacketTag (tag))
+    {
+      return;
+    }
+  // same classification as the queue discs: no tag is high priority
+  MyTag flowPrioTag;
+  FlowClass c = MICE;
+  if (packet->PeekPacketTag (flowPrioTag) && flowPrioTag.GetSimpleValue () != 0)
+    {
+      c = ELEPHANTS;
+    }
+  m_delay[c].Add (Simulator::Now ().GetNanoSeconds () - tag.m_txTime);
+}
+
+void
+FlowStatsCollector::AddReceiverAddress (Ipv4Address address)
+{
+  m_receivers.insert (address);
+}
+
+void
+FlowStatsCollector::AddFlowStats (const FlowMonitor::FlowStatsContainer &stats, Ptr<Ipv4FlowClassifier> classifier)
+{
+  NS_ABORT_MSG_IF (m_receivers.empty (), "No receiver address to tell the data flows from the ACK flows");
+  for (const auto &flow : stats)
+    {
+      const FlowMonitor::FlowStats &st = flow.second;
+      if (st.rxPackets == 0
+          || m_receivers.count (classifier->FindFlow (flow.first).destinationAddress) == 0)
+        {
+          continue;
+        }
+      FlowClass c = st.txBytes <= m_miceBytes ? MICE : ELEPHANTS;
+      m_fct[c].Add ((st.timeLastRxPacket - st.timeFirstTxPacket).GetNanoSeconds ());
+      Time rxTime = st.timeLastRxPacket - st.timeFirstRxPacket;
+      if (rxTime.IsStrictlyPositive ())
+        {
+          m_goodput[c].Add (static_cast<uint64_t> (st.rxBytes * 8.0 / rxTime.GetSeconds ()));
+        }
+    }
+}
+
+void
+FlowStatsCollector::Merge (const FlowStatsCollector &other)
+{
+  for (uint32_t c = 0; c < N_CLASSES; ++c)
+    {
+      m_delay[c].Merge (other.m_delay[c]);
+      m_fct[c].Merge (other.m_fct[c]);
+      m_goodput[c].Merge (other.m_goodput[c]);
+    }
+}
+
+static void
+PrintQuantiles (std::ostream &os, const std::string &name, const QuantileSketch &s,
+                double scale, const std::string &unit)
+{
+  os << "  " << name << " p50/p99/p99.9:   "
+     << s.GetQuantile (0.5) * scale << " / "
+     << s.GetQuantile (0.99) * scale << " / "
+     << s.GetQuantile (0.999) * scale << " " << unit
+     << " (" << s.GetCount () << " samples)" << std::endl;
+}
+
+void
+FlowStatsCollector::Print (std::ostream &os) const
+{
+  const char *names[N_CLASSES] = {"Mice", "Elephants"};
+  for (uint32_t c = 0; c < N_CLASSES; ++c)
+    {
+      PrintQuantiles (os, std::string (names[c]) + " packet delay", m_delay[c], 1e-6, "ms");
+      PrintQuantiles (os, std::string (names[c]) + " FCT", m_fct[c], 1e-6, "ms");
+      PrintQuantiles (os, std::string (names[c]) + " goodput", m_goodput[c], 1e-6, "Mbit/s");
+    }
+}
+
+const QuantileSketch &
+FlowStatsCollector::GetDelay (FlowClass c) const
+{
+  return m_delay[c];
+}
+
+const QuantileSketch &
+FlowStatsCollector::GetFct (FlowClass c) const
+{
+  return m_fct[c];
+}
+
+const QuantileSketch &
+FlowStatsCollector::GetGoodput (FlowClass c) const
+{
+  return m_goodput[c];
+}
+
+} // namespace ns3
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_STATS_COLLECTOR_H
+#define FLOW_STATS_COLLECTOR_H
+
+#include <array>
+#include <set>
+#include <ostream>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/flow-monitor-module.h"
+
+namespace ns3 {
+
+/**
+ * \brief Fixed size log-linear histogram (HDR histogram like) for quantiles.
+ *
+ * Values below 2^SUB_BITS are counted exactly. Above that, every power of two
+ * is split into 2^SUB_BITS buckets, so a quantile is within 2^-(SUB_BITS+1)
+ * of the true value (1.6% with 5 bits). The memory does not depend on the
+ * number of values, and two sketches merge by adding their counters.
+ */
+class QuantileSketch
+{
+public:
+  static const uint32_t SUB_BITS = 5;
+  static const uint32_t SUB_BUCKETS = 1 << SUB_BITS;
+  static const uint32_t N_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  QuantileSketch ();
+
+  void Add (uint64_t value);
+  /// add the counters of other to this sketch
+  void Merge (const QuantileSketch &other);
+  void Reset (void);
+
+  uint64_t GetCount (void) const;
+  uint64_t GetMin (void) const;
+  uint64_t GetMax (void) const;
+  double GetMean (void) const;
+  /**
+   * \param q the quantile, in [0, 1]
+   * \return the middle of the bucket of the q quantile, clamped to [min, max],
+   *         or 0 if the sketch is empty
+   */
+  uint64_t GetQuantile (double q) const;
+
+private:
+  static uint32_t GetBucket (uint64_t value);
+  static uint64_t GetBucketMiddle (uint32_t bucket);
+
+  std::array<uint64_t, N_BUCKETS> m_counts;
+  uint64_t m_count;
+  uint64_t m_min;
+  uint64_t m_max;
+  double m_sum;
+};
+
+/**
+ * \brief Collects flow completion time, one-way delay and goodput per class.
+ *
+ * The one-way delay is measured per packet at the IP layer: the senders stamp
+ * every packet they send (Ipv4L3Protocol SendOutgoing) and the receivers read
+ * the stamp when the packet is delivered locally (LocalDeliver). The class of
+ * a packet is its MyTag priority, 0 (high priority, mice) when it has none,
+ * as in the queue discs.
+ *
+ * FCT and goodput are per flow, taken from the FlowMonitor stats at the end
+ * of the run. Only the data flows count, the ones to a receiver address, so
+ * the TCP ACK flows back to the senders are left out. A flow is mice when it
+ * sent at most MiceBytes bytes, elephant otherwise. FCT is from the first
+ * sent to the last received packet.
+ *
+ * Everything goes into QuantileSketch-es, so memory is constant per class no
+ * matter the number of packets and flows.
+ */
+class FlowStatsCollector
+{
+public:
+  enum FlowClass
+  {
+    MICE = 0,
+    ELEPHANTS = 1,
+    N_CLASSES
+  };
+
+  FlowStatsCollector ();
+
+  /// \param miceBytes the largest flow, in bytes, counted as mice
+  void SetMiceBytes (uint64_t miceBytes);
+
+  /// stamp the packets sent by these nodes
+  void InstallSenders (NodeContainer senders);
+  /// measure the delay of the stamped packets delivered to these nodes
+  void InstallReceivers (NodeContainer receivers);
+
+  /// the flows to this address are data flows, needed on every rank
+  void AddReceiverAddress (Ipv4Address address);
+
+  /**
+   * \brief Add the FCT and goodput of the data flows that received something
+   * \param stats the FlowMonitor stats
+   * \param classifier the classifier of the FlowMonitor, for the flow destinations
+   */
+  void AddFlowStats (const FlowMonitor::FlowStatsContainer &stats, Ptr<Ipv4FlowClassifier> classifier);
+
+  /// add the sketches of other, e.g. from another run or MPI rank
+  void Merge (const FlowStatsCollector &other);
+
+  /// print p50/p99/p99.9 of every metric per class, as "key: value" lines
+  void Print (std::ostream &os) const;
+
+  const QuantileSketch &GetDelay (FlowClass c) const;
+  const QuantileSketch &GetFct (FlowClass c) const;
+  const QuantileSketch &GetGoodput (FlowClass c) const;
+
+private:
+  void Stamp (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+  void Deliver (const Ipv4Header &header, Ptr<const Packet> packet, uint32_t interface);
+
+  uint64_t m_miceBytes;
+  std::set<Ipv4Address> m_receivers;   //!< destinations of the data flows
+  QuantileSketch m_delay[N_CLASSES];    //!< one-way delay [ns]
+  QuantileSketch m_fct[N_CLASSES];      //!< flow completion time [ns]
+  QuantileSketch m_goodput[N_CLASSES];  //!< [bit/s]
+};
+
+} // namespace ns3
+
+#endif /* FLOW_STATS_COLLECTOR_H */
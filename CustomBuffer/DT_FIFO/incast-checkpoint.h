@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCAST_CHECKPOINT_H
+#define INCAST_CHECKPOINT_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \brief Checkpoint and warm start of the incast scenario.
+ *
+ * A save run writes, at the checkpoint time, the state that carries over the
+ * warm-up into a text file, then stops the simulation:
+ *  - the packets in the switch queue disc, with their age, priority tag,
+ *    IPv4 header and bytes, and the queue disc statistics;
+ *  - the sent counters of the CustomOnOffApplication and TutorialApp senders;
+ *  - the bytes received by the packet sink;
+ *  - the RngSeed and RngRun of the run.
+ *
+ * A restore run starts its senders at the checkpoint time instead of at the
+ * end of the warm-up, and puts the saved state back just before they start,
+ * so the simulator skips the warm-up events. Many variants can be restored
+ * from one checkpoint, as long as the topology and the traffic are the same
+ * (the scenario string); queue disc attributes, capacity, alphas, etc. may
+ * differ.
+ *
+ * The restart is statistically equivalent, not bit exact. ns-3 does not give
+ * access to the positions of the random streams, the sockets or the events
+ * in flight, so the senders restart their on/off cycle at the checkpoint with
+ * fresh random variables, and the few packets on the links and in the 1p
+ * device queue are lost. UDP only: TCP socket state is not saved. The
+ * FlowMonitor and FlowStatsCollector of a restore run only see the packets
+ * sent after the checkpoint.
+ */
+class IncastCheckpoint
+{
+public:
+  IncastCheckpoint ();
+
+  /// the topology and traffic parameters a checkpoint is valid for
+  void SetScenario (const std::string &scenario);
+  void SetQueueDisc (Ptr<QueueDisc> queueDisc);
+  /// add the next sender application, in sender order
+  void AddApplication (Ptr<Application> app);
+  void SetSink (Ptr<PacketSink> sink);
+
+  /**
+   * Save the state at the given time, then stop the simulation. Call before
+   * Simulator::Run, after SetQueueDisc.
+   * \param fileName the checkpoint file
+   * \param at the checkpoint time
+   */
+  void ScheduleSave (const std::string &fileName, Time at);
+
+  /**
+   * Read a checkpoint and check that it was taken with the same scenario.
+   * \param fileName the checkpoint file
+   * \return the checkpoint time, when the senders have to start
+   */
+  Time Load (const std::string &fileName);
+
+  /**
+   * Restore the senders now and the queue disc at the checkpoint time, before
+   * the senders start. Call after Load, once all applications are added.
+   */
+  void ScheduleRestore (void);
+
+  /// \return the bytes received by the sink before the checkpoint, 0 without one
+  uint64_t GetSinkRxBefore (void) const;
+
+private:
+  void Save (std::string fileName);
+  void Restore (void);
+  void Enqueued (Ptr<const QueueDiscItem> item);
+  void Dequeued (Ptr<const QueueDiscItem> item);
+
+  std::string m_scenario;
+  Ptr<QueueDisc> m_queueDisc;
+  std::vector<Ptr<Application> > m_apps;
+  Ptr<PacketSink> m_sink;
+  std::list<Ptr<const QueueDiscItem> > m_queued;   //!< the queue disc contents, head first
+
+  // loaded from a checkpoint
+  Time m_time;
+  QueueDisc::Stats m_stats;
+  std::vector<Ptr<QueueDiscItem> > m_items;
+  std::vector<Time> m_itemAges;
+  std::map<uint32_t, std::pair<uint64_t, uint64_t> > m_appCounters;  //!< sender -> (bytes, packets)
+  uint64_t m_sinkRx;
+};
+
+} // namespace ns3
+
+#endif /* INCAST_CHECKPOINT_H */
@@ -43,12 +43,16 @@
 #include "ns3/flow-monitor-module.h"
 #include "tutorial-app.h"
 #include "custom_onoff-application.h"
+#include "sim-profiler.h"
+#include "results-tables.h"
 
 
 using namespace ns3;
 
 std::string dir = "./CustomBuffer/Trace_Plots/";
 std::string queue_disc_type = "DT_FifoQueueDisc_v02";
+// the directory of the traces, dir + queue_disc_type unless set on the command line
+std::string traceDir;
 
 uint32_t prev = 0;
 Time prevTime = Seconds (0);
@@ -63,7 +67,7 @@ TraceThroughput (Ptr<FlowMonitor> monitor)
   FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
   auto itr = stats.begin ();
   Time curTime = Now ();
-  std::ofstream thr (dir + queue_disc_type + "/throughput.dat", std::ios::out | std::ios::app);
+  std::ofstream thr (traceDir + "/throughput.dat", std::ios::out | std::ios::app);
   thr <<  curTime << " " << 8 * (itr->second.txBytes - prev) / (1000 * 1000 * (curTime.GetSeconds () - prevTime.GetSeconds ())) << std::endl;
   prevTime = curTime;
   prev = itr->second.txBytes;
@@ -75,7 +79,7 @@ void CheckQueueSize (Ptr<QueueDisc> qd)
 {
   uint32_t qsize = qd->GetCurrentSize ().GetValue ();
   Simulator::Schedule (Seconds (0.1), &CheckQueueSize, qd);
-  std::ofstream q (dir + queue_disc_type + "/queueSize.dat", std::ios::out | std::ios::app);
+  std::ofstream q (traceDir + "/queueSize.dat", std::ios::out | std::ios::app);
   q << Simulator::Now ().GetSeconds () << " " << qsize << std::endl;
   q.close ();
 }
@@ -112,7 +116,7 @@ TcPacketsInQueueTrace (uint32_t oldValue, uint32_t newValue)
 void
 TcHighPriorityPacketsInQueueTrace (uint32_t oldValue, uint32_t newValue)
 {
-  std::ofstream hppiq (dir + queue_disc_type + "/highPriorityPacketsInQueueTrace.dat", std::ios::out | std::ios::app);
+  std::ofstream hppiq (traceDir + "/highPriorityPacketsInQueueTrace.dat", std::ios::out | std::ios::app);
   hppiq << Simulator::Now ().GetSeconds () << " " << newValue << std::endl;
   hppiq.close ();
 
@@ -123,7 +127,7 @@ TcHighPriorityPacketsInQueueTrace (uint32_t oldValue, uint32_t newValue)
 void
 TcLowPriorityPacketsInQueueTrace (uint32_t oldValue, uint32_t newValue)
 {
-  std::ofstream lppiq (dir + queue_disc_type + "/lowPriorityPacketsInQueueTrace.dat", std::ios::out | std::ios::app);
+  std::ofstream lppiq (traceDir + "/lowPriorityPacketsInQueueTrace.dat", std::ios::out | std::ios::app);
   lppiq << Simulator::Now ().GetSeconds () << " " << newValue << std::endl;
   lppiq.close ();
 
@@ -134,7 +138,7 @@ TcLowPriorityPacketsInQueueTrace (uint32_t oldValue, uint32_t newValue)
 void
 QueueThresholdHighTrace (uint32_t oldValue, uint32_t newValue)  // added by me, to monitor Threshold
 {
-  std::ofstream hpthr (dir + queue_disc_type + "/highPriorityQueueThreshold.dat", std::ios::out | std::ios::app);
+  std::ofstream hpthr (traceDir + "/highPriorityQueueThreshold.dat", std::ios::out | std::ios::app);
   hpthr << Simulator::Now ().GetSeconds () << " " << newValue << std::endl;
   hpthr.close ();
 
@@ -145,7 +149,7 @@ QueueThresholdHighTrace (uint32_t oldValue, uint32_t newValue)  // added by me,
 void
 QueueThresholdLowTrace (uint32_t oldValue, uint32_t newValue)  // added by me, to monitor Threshold
 {
-  std::ofstream lpthr (dir + queue_disc_type + "/lowPriorityQueueThreshold.dat", std::ios::out | std::ios::app);
+  std::ofstream lpthr (traceDir + "/lowPriorityQueueThreshold.dat", std::ios::out | std::ios::app);
   lpthr << Simulator::Now ().GetSeconds () << " " << newValue << std::endl;
   lpthr.close ();
   
@@ -173,19 +177,46 @@ int main (int argc, char *argv[])
   std::string socketType;
   std::string queue_capacity;
   bool enablePcap = false;  // true/false
+  std::string senderRate = "10Mbps";
+  std::string senderDelay = "5ms";
+  std::string bottleneckRate = "100Kbps";
+  std::string bottleneckDelay = "10ms";
+  uint64_t miceBytes = 100000;
+  std::string results;
+
+  bool profile = false;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue("Simulation Time", "The total time for the simulation to run", simulationTime);
   cmd.AddValue ("applicationType", "Application type to use to send data: OnOff, standardClient, customOnOff", applicationType);
   cmd.AddValue ("transportProt", "Transport protocol to use: Tcp, Udp", transportProt);
+  cmd.AddValue ("queueCapacity", "The queue disc size B, e.g. 100p, default depends on the application type", queue_capacity);
+  cmd.AddValue ("senderRate", "The data rate of the sender link", senderRate);
+  cmd.AddValue ("senderDelay", "The delay of the sender link", senderDelay);
+  cmd.AddValue ("bottleneckRate", "The data rate of the bottleneck link", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "The delay of the bottleneck link", bottleneckDelay);
+  cmd.AddValue ("miceBytes", "The largest flow [bytes] counted as mice in the results file", miceBytes);
+  cmd.AddValue ("results", "Also write the per flow and queue disc statistics to this columnar binary file", results);
+  cmd.AddValue ("traceDir", "The directory of the queue traces, default " + dir + queue_disc_type, traceDir);
+  // the queue disc alphas and the mice threshold are attributes, e.g.
+  // --ns3::DT_FifoQueueDisc_v02::AlphaHigh=4 --CustomOnOffApplication::MiceThreshold=20
+  cmd.AddValue ("profile", "Print the events and packets per wall second and the queue disc hot path time", profile);
   cmd.Parse (argc, argv);
+  if (traceDir.empty ())
+    {
+      traceDir = dir + queue_disc_type;
+    }
   
   // Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));
   // Config::SetDefault ("ns3::UdpSocket::InitialCwnd", UintegerValue (1));
   // Config::SetDefault ("ns3::TcpL4Protocol::RecoveryType", TypeIdValue (TypeId::LookupByName ("ns3::TcpClassicRecovery")));
 
   // Application type dependent parameters
-  if (applicationType.compare("standardClient") == 0)
+  if (!queue_capacity.empty ())
+    {
+      // set on the command line
+    }
+  else if (applicationType.compare("standardClient") == 0)
     {
       queue_capacity = "20p"; // B, the total space on the buffer
     }
@@ -242,13 +273,13 @@ int main (int argc, char *argv[])
   
   // Create the point-to-point link helpers
   PointToPointHelper p2p1;  // the link from sender to Router
-  p2p1.SetDeviceAttribute  ("DataRate", StringValue ("10Mbps"));
-  p2p1.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  p2p1.SetDeviceAttribute  ("DataRate", StringValue (senderRate));
+  p2p1.SetChannelAttribute ("Delay", StringValue (senderDelay));
   // p2p1.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
 
   PointToPointHelper p2p2;  // the link between router and Reciever
-  p2p2.SetDeviceAttribute  ("DataRate", StringValue ("100Kbps"));
-  p2p2.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  p2p2.SetDeviceAttribute  ("DataRate", StringValue (bottleneckRate));
+  p2p2.SetChannelAttribute ("Delay", StringValue (bottleneckDelay));
   // min value for NetDevice buffer is 1p. we set it in order to observe Traffic Controll effects only.
   p2p2.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
 
@@ -277,8 +308,9 @@ int main (int argc, char *argv[])
   q->TraceConnectWithoutContext ("LowPriorityPacketsInQueue", MakeCallback (&TcLowPriorityPacketsInQueueTrace));  // ### ADDED BY ME #####
   q->TraceConnectWithoutContext("EnqueueingThreshold_High", MakeCallback (&QueueThresholdHighTrace)); // ### ADDED BY ME #####
   q->TraceConnectWithoutContext("EnqueueingThreshold_Low", MakeCallback (&QueueThresholdLowTrace)); // ### ADDED BY ME #####
-  Config::ConnectWithoutContextFailSafe ("/NodeList/1/$ns3::TrafficControlLayer/RootQueueDiscList/0/SojournTime",
-                                 MakeCallback (&SojournTimeTrace));                          
+  // per packet sojourn times, the per class histogram is printed at the end
+  // Config::ConnectWithoutContextFailSafe ("/NodeList/1/$ns3::TrafficControlLayer/RootQueueDiscList/0/SojournTime",
+  //                                MakeCallback (&SojournTimeTrace));                          
 
 
   ////////////////////////////////////////////////////////
@@ -386,7 +418,7 @@ int main (int argc, char *argv[])
   Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
   // Create a new directory to store the output of the program
-  std::string dirToSave = "mkdir -p " + dir + queue_disc_type;
+  std::string dirToSave = "mkdir -p " + traceDir;
   if (system (dirToSave.c_str ()) == -1)
     {
       exit (1);
@@ -414,10 +446,15 @@ int main (int argc, char *argv[])
         {
           exit (1);
         }
-      p2p2.EnablePcapAll (dir + queue_disc_type + "/pcap/dt", true);
+      p2p2.EnablePcapAll (traceDir + "/pcap/dt", true);
     }
 
   Simulator::Stop (Seconds (simulationTime + 10));
+  if (profile)
+    {
+      // the summary is printed by Simulator::Destroy
+      SimProfiler::Get ().Enable ();
+    }
   Simulator::Run ();
 
   Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
@@ -467,6 +504,16 @@ int main (int argc, char *argv[])
   std::cout << "  Average Goodput: " << thr << " Mbit/s" << std::endl;
   std::cout << std::endl << "*** TC Layer statistics ***" << std::endl;
   std::cout << q->GetStats () << std::endl;
+  q->GetStats ().PrintSojournHistograms (std::cout);
+
+  // the same statistics in one file per run, for the results tool
+  if (!results.empty ())
+    {
+      ColumnarResults tables;
+      AddFlowTable (tables, stats, classifier, miceBytes);
+      AddQueueDiscRow (tables, 0, q->GetStats ());
+      tables.Write (results);
+    }
   
   // command line needs to be in ./scratch/ inorder for the script to produce gnuplot correctly///
   // system (("gnuplot " + dir + "gnuplotScriptTcHighPriorityPacketsInQueue").c_str ());
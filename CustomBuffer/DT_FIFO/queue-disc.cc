@@ -17,9 +17,13 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <algorithm>
+#include <sstream>
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
 #include "ns3/pointer.h"
 #include "ns3/object-vector.h"
 #include "ns3/packet.h"
@@ -29,6 +33,7 @@
 #include "ns3/queue.h"
 #include "queue-disc.h"
 #include "customTag.h"
+#include "sim-profiler.h"
 
 namespace ns3 {
 
@@ -108,6 +113,8 @@ QueueDisc::Stats::Stats ()
     nTotalMarkedPackets (0),
     nTotalMarkedBytes (0)
 {
+  sojournHistogramHighPriority.fill (0);
+  sojournHistogramLowPriority.fill (0);
 }
 
 uint32_t
@@ -178,6 +185,47 @@ QueueDisc::Stats::GetNMarkedBytes (std::string reason) const
   return 0;
 }
 
+uint32_t
+QueueDisc::Stats::GetSojournBucket (Time sojourn)
+{
+  uint64_t us = std::max<int64_t> (sojourn.GetMicroSeconds (), 0);
+  if (us == 0)
+    {
+      return 0;
+    }
+  return std::min<uint32_t> (64 - __builtin_clzll (us), N_SOJOURN_BUCKETS - 1);
+}
+
+void
+QueueDisc::Stats::PrintSojournHistograms (std::ostream &os) const
+{
+  const std::array<uint32_t, N_SOJOURN_BUCKETS> *histograms[] = {&sojournHistogramHighPriority,
+                                                                 &sojournHistogramLowPriority};
+  const char *names[] = {"High", "Low"};
+  for (uint32_t c = 0; c < 2; ++c)
+    {
+      os << names[c] << " Priority sojourn time histogram [us]" << std::endl;
+      for (uint32_t i = 0; i < N_SOJOURN_BUCKETS; ++i)
+        {
+          if ((*histograms[c])[i] == 0)
+            {
+              continue;
+            }
+          uint64_t lower = i == 0 ? 0 : 1ULL << (i - 1);
+          os << "  " << lower << " - ";
+          if (i == N_SOJOURN_BUCKETS - 1)
+            {
+              os << "inf";
+            }
+          else
+            {
+              os << (1ULL << i);
+            }
+          os << "\t" << (*histograms[c])[i] << std::endl;
+        }
+    }
+}
+
 void
 QueueDisc::Stats::Print (std::ostream &os) const
 {
@@ -293,6 +341,32 @@ TypeId QueueDisc::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_classes),
                    MakeObjectVectorChecker<QueueDiscClass> ())
+    .AddAttribute ("FlightRecorderSize",
+                   "Number of events kept by the flight recorder, 0 disables it",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&QueueDisc::m_flightSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlightRecorderPostEvents",
+                   "Number of events recorded after the drop condition fired, before the dump",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&QueueDisc::m_flightPostEvents),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlightRecorderMaxDumps",
+                   "Number of dumps after which the drop condition is ignored, 0 for no limit",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&QueueDisc::m_flightMaxDumps),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlightRecorderTrigger",
+                   "Drop condition that writes the flight recorder to disk",
+                   EnumValue (FLIGHT_HIGH_PRIORITY_DROP),
+                   MakeEnumAccessor (&QueueDisc::m_flightTrigger),
+                   MakeEnumChecker (FLIGHT_HIGH_PRIORITY_DROP, "HighPriorityDrop",
+                                    FLIGHT_ANY_DROP, "Drop"))
+    .AddAttribute ("FlightRecorderFile",
+                   "Prefix of the flight recorder file, -<n>.tsv is appended",
+                   StringValue ("flight-recorder"),
+                   MakeStringAccessor (&QueueDisc::m_flightFile),
+                   MakeStringChecker ())
     .AddTraceSource ("Enqueue", "Enqueue a packet in the queue disc",
                      MakeTraceSourceAccessor (&QueueDisc::m_traceEnqueue),
                      "ns3::QueueDiscItem::TracedCallback")
@@ -424,6 +498,12 @@ QueueDisc::DoDispose (void)
   m_internalQueueDadFunctor = nullptr;
   m_childQueueDiscDbeFunctor = nullptr;
   m_childQueueDiscDadFunctor = nullptr;
+  if (m_flightPending != 0)
+    {
+      // the run ended before the events after the trigger were recorded
+      DumpFlightRecorder ();
+    }
+  m_flightOut.reset ();
   Object::DoDispose ();
 }
 
@@ -437,6 +517,15 @@ QueueDisc::DoInitialize (void)
   NS_ASSERT_MSG (ok, "The queue disc configuration is not correct");
   InitializeParams ();
 
+  if (SimProfiler::Get ().IsEnabled ())
+    {
+      m_profilerId = SimProfiler::Get ().AddQueueDisc (GetInstanceTypeId ().GetName ());
+    }
+  if (m_flightSize != 0)
+    {
+      m_flightEvents.assign (m_flightSize, FlightEvent ());
+    }
+
   // Check the configuration and initialize the parameters of the child queue discs
   for (std::vector<Ptr<QueueDiscClass> >::iterator cl = m_classes.begin ();
        cl != m_classes.end (); cl++)
@@ -466,6 +555,105 @@ QueueDisc::GetStats (void)
   return m_stats;
 }
 
+uint32_t
+QueueDisc::RestoreCheckpoint (const std::vector<Ptr<QueueDiscItem> > &items, const Stats &stats)
+{
+  NS_LOG_FUNCTION (this << items.size ());
+  NS_ABORT_MSG_IF (GetNInternalQueues () != 1 || GetNQueueDiscClasses () != 0,
+                   "Only queue discs with a single internal queue can be restored");
+  NS_ABORT_MSG_IF (m_nPackets != 0, "The queue disc to restore is not empty");
+
+  // the saved statistics count every item as enqueued. PacketEnqueued counts
+  // the items that fit once more and DropBeforeEnqueue counts the ones that
+  // do not fit in a smaller queue disc as drops, so taking all of them out of
+  // the enqueued totals keeps the statistics consistent with m_nPackets
+  m_stats = stats;
+  uint32_t dropped = 0;
+  uint64_t bytes = 0;
+  for (const Ptr<QueueDiscItem> &item : items)
+    {
+      bytes += item->GetSize ();
+      dropped += GetInternalQueue (0)->Enqueue (item) ? 0 : 1;
+    }
+  m_stats.nTotalEnqueuedPackets -= items.size ();
+  m_stats.nTotalEnqueuedBytes -= bytes;
+  NS_LOG_LOGIC ("Restored " << m_nPackets << " packets, " << dropped << " did not fit");
+  Run ();
+  return dropped;
+}
+
+void
+QueueDisc::TriggerFlightRecorder (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_flightEvents.empty () || m_flightPending != 0
+      || (m_flightMaxDumps != 0 && m_flightDumps >= m_flightMaxDumps))
+    {
+      return;
+    }
+  if (m_flightPostEvents == 0)
+    {
+      DumpFlightRecorder ();
+    }
+  else
+    {
+      m_flightPending = m_flightPostEvents;
+    }
+}
+
+void
+QueueDisc::RecordFlightEvent (FlightEventType type, uint8_t priority, uint32_t value)
+{
+  FlightEvent &event = m_flightEvents[m_flightHead];
+  event.time = Simulator::Now ().GetTimeStep ();
+  event.nPacketsHigh = m_nPackets_h;
+  event.nPacketsLow = m_nPackets_l;
+  event.value = value;
+  event.type = type;
+  event.priority = priority;
+  m_flightHead = m_flightHead + 1 < m_flightEvents.size () ? m_flightHead + 1 : 0;
+  m_flightCount = std::min<uint32_t> (m_flightCount + 1, m_flightEvents.size ());
+  if (m_flightPending != 0 && --m_flightPending == 0)
+    {
+      DumpFlightRecorder ();
+    }
+}
+
+void
+QueueDisc::DumpFlightRecorder (void)
+{
+  NS_LOG_FUNCTION (this << m_flightCount);
+  static uint32_t nRecorders = 0;
+  static const char *names[] = {"enqueue", "dequeue", "drop", "threshold"};
+
+  if (!m_flightOut)
+    {
+      std::ostringstream fileName;
+      fileName << m_flightFile << "-" << nRecorders++ << ".tsv";
+      m_flightOut.reset (new std::ofstream (fileName.str ()));
+      NS_ABORT_MSG_IF (!*m_flightOut, "Can not open " << fileName.str ());
+      *m_flightOut << "dump\ttimeNs\tevent\tclass\tvalue\tpacketsHigh\tpacketsLow\n";
+    }
+
+  // the oldest event not dumped yet is m_flightCount events behind the head
+  uint32_t size = m_flightEvents.size ();
+  uint32_t i = (m_flightHead + size - m_flightCount) % size;
+  for (uint32_t n = 0; n < m_flightCount; ++n)
+    {
+      const FlightEvent &event = m_flightEvents[i];
+      *m_flightOut << m_flightDumps << "\t" << TimeStep (event.time).GetNanoSeconds ()
+                   << "\t" << names[event.type] << "\t" << static_cast<uint32_t> (event.priority)
+                   << "\t" << event.value << "\t" << event.nPacketsHigh
+                   << "\t" << event.nPacketsLow << "\n";
+      i = i + 1 < size ? i + 1 : 0;
+    }
+  m_flightOut->flush ();
+  NS_LOG_LOGIC ("Flight recorder dump " << m_flightDumps << ", " << m_flightCount << " events");
+  m_flightDumps++;
+  m_flightCount = 0;
+  m_flightPending = 0;
+}
+
 uint32_t
 QueueDisc::GetNPackets () const
 {
@@ -567,40 +755,80 @@ QueueDisc::GetCurrentSize (void)
 
 
 QueueSize
-QueueDisc::GetQueueThreshold (int alpha, int alpha_l, int alpha_h)  // added by me!!!!!!!!!!!
+QueueDisc::GetQueueThreshold (uint8_t priority, uint32_t alphaFp)  // added by me!!!!!!!!!!!
 {
   NS_LOG_FUNCTION (this);
+  SimProfiler::Scope scope (SimProfiler::THRESHOLD);
+  uint64_t factorFp = GetThresholdFactor (priority);
+  uint64_t room = GetMaxSize ().GetValue () - GetCurrentSize ().GetValue ();
+  // alpha_c * factor * (B - Q(t)), both scaled by 2^ALPHA_SHIFT
+  uint32_t threshold = static_cast<uint32_t> ((((alphaFp * room) >> ALPHA_SHIFT) * factorFp) >> ALPHA_SHIFT);
+  uint8_t c = priority == 0 ? 0 : 1;
+  if (!m_flightEvents.empty () && threshold != m_flightThreshold[c])
+    {
+      m_flightThreshold[c] = threshold;
+      RecordFlightEvent (FLIGHT_THRESHOLD, c, threshold);
+    }
 
   if (GetMaxSize ().GetUnit () == QueueSizeUnit::PACKETS)
     {
-      if (alpha == alpha_h)
+      if (priority == 0)
       {
-        m_p_threshold_h = alpha_h * (GetMaxSize ().GetValue () - GetCurrentSize ().GetValue ());
+        m_p_threshold_h = threshold;
         return QueueSize (QueueSizeUnit::PACKETS, m_p_threshold_h);
       }
       else
       {
-        m_p_threshold_l = alpha_l * (GetMaxSize ().GetValue () - GetCurrentSize ().GetValue ());
+        m_p_threshold_l = threshold;
         return QueueSize (QueueSizeUnit::PACKETS, m_p_threshold_l);
       }
       
     }
   if (GetMaxSize ().GetUnit () == QueueSizeUnit::BYTES)
     {
-      if (alpha == alpha_h)
+      if (priority == 0)
       {
-        m_b_threshold_h = alpha_h * (GetMaxSize ().GetValue () - GetCurrentSize ().GetValue ());
-        return QueueSize (QueueSizeUnit::PACKETS, m_b_threshold_h);
+        m_b_threshold_h = threshold;
+        return QueueSize (QueueSizeUnit::BYTES, m_b_threshold_h);
       }
       else
       {
-        m_p_threshold_l = alpha_l * (GetMaxSize ().GetValue () - GetCurrentSize ().GetValue ());
-        return QueueSize (QueueSizeUnit::PACKETS, m_b_threshold_l);
+        m_b_threshold_l = threshold;
+        return QueueSize (QueueSizeUnit::BYTES, m_b_threshold_l);
       }
     }
   NS_ABORT_MSG ("Unknown Threshod unit");
 }
 
+uint32_t
+QueueDisc::AlphaToFixedPoint (double alpha)
+{
+  NS_ABORT_MSG_IF (alpha < 0, "Negative alpha " << alpha);
+  return static_cast<uint32_t> (alpha * (1 << ALPHA_SHIFT) + 0.5);
+}
+
+uint32_t
+QueueDisc::GetThresholdFactor (uint8_t priority)
+{
+  return 1 << ALPHA_SHIFT;
+}
+
+int
+QueueDisc::GetNCongestedClasses (void) const
+{
+  // a class is congested once its occupancy has reached its current threshold
+  int numConjestedQueues = 0;
+  if (m_p_threshold_h <= m_nPackets_h)
+    {
+      numConjestedQueues++;
+    }
+  if (m_p_threshold_l <= m_nPackets_l)
+    {
+      numConjestedQueues++;
+    }
+  return numConjestedQueues;
+}
+
 void
 QueueDisc::SetNetDeviceQueueInterface (Ptr<NetDeviceQueueInterface> ndqi)
 {
@@ -783,8 +1011,13 @@ QueueDisc::PacketEnqueued (Ptr<const QueueDiscItem> item)
   m_nBytes += item->GetSize ();
   m_stats.nTotalEnqueuedPackets++;
   m_stats.nTotalEnqueuedBytes += item->GetSize ();
+  if (!m_flightEvents.empty ())
+    {
+      RecordFlightEvent (FLIGHT_ENQUEUE, flow_priority, item->GetSize ());
+    }
 
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
+  SimProfiler::Scope scope (SimProfiler::TRACE);
   m_traceEnqueue (item);
 }
 
@@ -818,9 +1051,23 @@ QueueDisc::PacketDequeued (Ptr<const QueueDiscItem> item)
       m_stats.nTotalDequeuedPackets++;
       m_stats.nTotalDequeuedBytes += item->GetSize ();
 
-      m_sojourn (Simulator::Now () - item->GetTimeStamp ());
-
+      Time sojourn = Simulator::Now () - item->GetTimeStamp ();
+      // per class histogram, flow_priority is the class of this packet from above
+      if (flow_priority == 0)
+        {
+          m_stats.sojournHistogramHighPriority[Stats::GetSojournBucket (sojourn)]++;
+        }
+      else
+        {
+          m_stats.sojournHistogramLowPriority[Stats::GetSojournBucket (sojourn)]++;
+        }
+      if (!m_flightEvents.empty ())
+        {
+          RecordFlightEvent (FLIGHT_DEQUEUE, flow_priority, item->GetSize ());
+        }
       NS_LOG_LOGIC ("m_traceDequeue (p)");
+      SimProfiler::Scope scope (SimProfiler::TRACE);
+      m_sojourn (sojourn);
       m_traceDequeue (item);
     }
 }
@@ -850,6 +1097,14 @@ QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
       m_stats.nTotalDroppedPacketsBeforeEnqueueLowPriority++;
       m_stats.nTotalDroppedBytesBeforeEnqueueLowPriority += item->GetSize ();
     }
+  if (!m_flightEvents.empty ())
+    {
+      RecordFlightEvent (FLIGHT_DROP, flow_priority, item->GetSize ());
+      if (flow_priority == 0 || m_flightTrigger == FLIGHT_ANY_DROP)
+        {
+          TriggerFlightRecorder ();
+        }
+    }
   //////////////////////////////
 
   // update the number of packets dropped for the given reason
@@ -884,6 +1139,7 @@ QueueDisc::DropBeforeEnqueue (Ptr<const QueueDiscItem> item, const char* reason)
                 << m_stats.nTotalDroppedPacketsBeforeEnqueue << " / "
                 << m_stats.nTotalDroppedBytesBeforeEnqueue);
   NS_LOG_LOGIC ("m_traceDropBeforeEnqueue (p)");
+  SimProfiler::Scope scope (SimProfiler::TRACE);
   m_traceDrop (item);
   m_traceDropBeforeEnqueue (item, reason);
 }
@@ -930,10 +1186,21 @@ QueueDisc::DropAfterDequeue (Ptr<const QueueDiscItem> item, const char* reason)
       m_peeked = true;
     }
 
+  if (!m_flightEvents.empty ())
+    {
+      uint8_t priority = item->GetPacket ()->PeekPacketTag (flowPrioTag) ? flowPrioTag.GetSimpleValue () : 0;
+      RecordFlightEvent (FLIGHT_DROP, priority, item->GetSize ());
+      if (m_flightTrigger == FLIGHT_ANY_DROP)
+        {
+          TriggerFlightRecorder ();
+        }
+    }
+
   NS_LOG_DEBUG ("Total packets/bytes dropped after dequeue: "
                 << m_stats.nTotalDroppedPacketsAfterDequeue << " / "
                 << m_stats.nTotalDroppedBytesAfterDequeue);
   NS_LOG_LOGIC ("m_traceDropAfterDequeue (p)");
+  SimProfiler::Scope scope (SimProfiler::TRACE);
   m_traceDrop (item);
   m_traceDropAfterDequeue (item, reason);
 }
@@ -989,7 +1256,11 @@ QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
   m_stats.nTotalReceivedPackets++;
   m_stats.nTotalReceivedBytes += item->GetSize ();
 
-  bool retval = DoEnqueue (item);
+  bool retval;
+  {
+    SimProfiler::Scope scope (SimProfiler::ENQUEUE);
+    retval = DoEnqueue (item);
+  }
 
   if (retval)
     {
@@ -1041,9 +1312,15 @@ QueueDisc::Dequeue (void)
     }
   else
     {
+      SimProfiler::Scope scope (SimProfiler::DEQUEUE);
       item = DoDequeue ();
     }
 
+  if (item && m_profilerId != UINT32_MAX)
+    {
+      SimProfiler::Get ().CountPacket (m_profilerId);
+    }
+
   NS_ASSERT (m_nPackets == m_stats.nTotalEnqueuedPackets - m_stats.nTotalDequeuedPackets);
   NS_ASSERT (m_nBytes == m_stats.nTotalEnqueuedBytes - m_stats.nTotalDequeuedBytes);
 
@@ -25,10 +25,13 @@
 #include "ns3/traced-callback.h"
 #include "ns3/queue-item.h"
 #include "ns3/queue-size.h"
+#include <array>
 #include <vector>
 #include <map>
 #include <functional>
 #include <string>
+#include <fstream>
+#include <memory>
 #include "ns3/packet-filter.h"
 
 namespace ns3 {
@@ -244,6 +247,12 @@ public:
     uint32_t nTotalMarkedBytes;
     /// Marked bytes, for each reason
     std::map<std::string, uint64_t, std::less<>> nMarkedBytes;
+    /// Number of buckets of the sojourn time histograms
+    static constexpr uint32_t N_SOJOURN_BUCKETS = 32;
+    /// High Priority sojourn times, bucket 0 is below 1 us and bucket i in [2^(i-1), 2^i) us
+    std::array<uint32_t, N_SOJOURN_BUCKETS> sojournHistogramHighPriority;  // added by me
+    /// Low Priority sojourn times, same buckets as the High Priority histogram
+    std::array<uint32_t, N_SOJOURN_BUCKETS> sojournHistogramLowPriority;  // added by me
 
     /// constructor
     Stats ();
@@ -272,6 +281,17 @@ public:
      * \return the amount of bytes marked for the given reason
      */
     uint64_t GetNMarkedBytes (std::string reason) const;
+    /**
+     * \brief Get the sojourn time histogram bucket of a sojourn time
+     * \param sojourn the sojourn time
+     * \return the bucket index, the last bucket also holds all longer times
+     */
+    static uint32_t GetSojournBucket (Time sojourn);
+    /**
+     * \brief Print the non empty buckets of both sojourn time histograms
+     * \param os output stream
+     */
+    void PrintSojournHistograms (std::ostream &os) const;
     /**
      * \brief Print the statistics.
      * \param os output stream in which the data should be printed.
@@ -368,11 +388,25 @@ public:
   QueueSize GetCurrentSize (void);
 
     /**
-   * \brief Get the queueing limit of the current queue for each priority alpha.
+   * \brief Get the queueing limit of the current queue for a priority class.
    *
-   * \returns the maximum number of packets in the queue.
+   * T_c(t) = alpha_c * factor(t) * (B - Q(t)), see GetThresholdFactor.
+   * \param priority the class, 0 is high priority, anything else low priority
+   * \param alphaFp alpha_c in fixed point, see AlphaToFixedPoint
+   * \returns the maximum number of packets (bytes) in the queue for that class.
+   */
+  QueueSize GetQueueThreshold (uint8_t priority, uint32_t alphaFp);
+
+  /// Number of fractional bits of the fixed point alphas and threshold factors
+  static constexpr uint32_t ALPHA_SHIFT = 16;
+
+  /**
+   * Convert an alpha (or any threshold factor) to the fixed point format
+   * used by GetQueueThreshold, so the enqueue path has no floating point.
+   * \param alpha the value to convert, must not be negative
+   * \return alpha * 2^ALPHA_SHIFT, rounded
    */
-  QueueSize GetQueueThreshold (int alpha, int alpha_h, int alpha_l);
+  static uint32_t AlphaToFixedPoint (double alpha);
 
   /**
    * \brief Retrieve all the collected statistics.
@@ -380,6 +414,46 @@ public:
    */
   const Stats& GetStats (void);
 
+  /**
+   * \brief Put back the contents and the statistics saved by a checkpoint.
+   *
+   * The statistics are first replaced by \p stats, then the items go
+   * straight into the internal queue, in order, without the admission of
+   * DoEnqueue, and the transmission is restarted. \p stats already counts
+   * the items as enqueued, so their totals are taken out of the enqueued
+   * statistics again; an item that does not fit is counted as a drop before
+   * enqueue. The caller sets the time stamps of the items. Only for an empty
+   * queue disc with one internal queue and no classes, like the DT and FB
+   * queue discs.
+   *
+   * \param items the packets in the queue disc, head first
+   * \param stats the statistics at the checkpoint
+   * \return the number of items that did not fit in the internal queue, they
+   *         are counted as drops before enqueue instead of as enqueued
+   */
+  uint32_t RestoreCheckpoint (const std::vector<Ptr<QueueDiscItem> > &items, const Stats &stats);
+
+  /// Drop condition that makes the flight recorder write its events to disk
+  enum FlightRecorderTrigger
+    {
+      FLIGHT_HIGH_PRIORITY_DROP,  //!< nTotalDroppedPacketsBeforeEnqueueHighPriority increments
+      FLIGHT_ANY_DROP             //!< any packet is dropped
+    };
+
+  /**
+   * \brief Write the flight recorder to disk as if its drop condition fired.
+   *
+   * The flight recorder is a circular log of the last FlightRecorderSize
+   * enqueue, dequeue, drop and threshold change events of the queue disc,
+   * with their time, class and the occupancy of both classes after the
+   * event. Recording an event is a few stores into memory. When the drop
+   * condition fires, FlightRecorderPostEvents more events are recorded, then
+   * the events logged since the previous dump are appended to the file
+   * "<FlightRecorderFile>-<n>.tsv", n numbering the recording queue discs.
+   * Disabled (FlightRecorderSize 0) by default.
+   */
+  void TriggerFlightRecorder (void);
+
   /**
    * \param ndqi the NetDeviceQueueInterface aggregated to the receiving object.
    *
@@ -606,6 +680,22 @@ protected:
    */
   bool Mark (Ptr<QueueDiscItem> item, const char* reason);
 
+  /**
+   * \brief Factor applied to alpha * (B - Q(t)) by GetQueueThreshold
+   *
+   * The plain dynamic threshold (DT) uses 1. A subclass overrides this to
+   * scale the thresholds, e.g. FB by the share of classes that are not
+   * congested and the dequeue rate of the class.
+   * \param priority the class, 0 is high priority, anything else low priority
+   * \return the threshold factor in fixed point, 1 is 1 << ALPHA_SHIFT
+   */
+  virtual uint32_t GetThresholdFactor (uint8_t priority);
+
+  /**
+   * \return the number of priority classes whose occupancy has reached their threshold
+   */
+  int GetNCongestedClasses (void) const;
+
 private:
   /**
    * This function actually enqueues a packet into the queue disc.
@@ -717,6 +807,37 @@ private:
    */
   void PacketDequeued (Ptr<const QueueDiscItem> item);
 
+  /// Kinds of the flight recorder events
+  enum FlightEventType : uint8_t
+    {
+      FLIGHT_ENQUEUE,
+      FLIGHT_DEQUEUE,
+      FLIGHT_DROP,
+      FLIGHT_THRESHOLD
+    };
+
+  /// An event of the flight recorder, 24 bytes
+  struct FlightEvent
+  {
+    int64_t time;            //!< Simulator::Now () in time steps
+    uint32_t nPacketsHigh;   //!< High Priority packets in the queue disc after the event
+    uint32_t nPacketsLow;    //!< Low Priority packets in the queue disc after the event
+    uint32_t value;          //!< packet size, or the new threshold
+    uint8_t type;            //!< a FlightEventType
+    uint8_t priority;        //!< class of the packet or of the threshold
+  };
+
+  /**
+   * \brief Append an event to the flight recorder, which must be enabled
+   * \param type the kind of event
+   * \param priority the class, 0 is high priority
+   * \param value the packet size, or the new threshold
+   */
+  void RecordFlightEvent (FlightEventType type, uint8_t priority, uint32_t value);
+
+  /// Write the events recorded since the previous dump to the flight recorder file
+  void DumpFlightRecorder (void);
+
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<InternalQueue> > m_queues;    //!< Internal queues
@@ -741,6 +862,19 @@ private:
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
   Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
   bool m_peeked;                    //!< A packet was dequeued because Peek was called
+  uint32_t m_profilerId {UINT32_MAX}; //!< Id in the SimProfiler, UINT32_MAX when not profiled
+  uint32_t m_flightSize;                //!< Events kept by the flight recorder, 0 disables it
+  uint32_t m_flightPostEvents;          //!< Events recorded after the trigger, before the dump
+  uint32_t m_flightMaxDumps;            //!< Dumps after which the trigger is ignored, 0 for no limit
+  FlightRecorderTrigger m_flightTrigger;  //!< Drop condition of the flight recorder
+  std::string m_flightFile;             //!< Prefix of the flight recorder file
+  std::vector<FlightEvent> m_flightEvents;  //!< The circular log
+  uint32_t m_flightHead {0};            //!< Next event to write
+  uint32_t m_flightCount {0};           //!< Events logged since the previous dump
+  uint32_t m_flightPending {0};         //!< Events still to record before a dump, 0 when not triggered
+  uint32_t m_flightDumps {0};           //!< Dumps written
+  uint32_t m_flightThreshold[2] {0, 0}; //!< Last recorded threshold of each class
+  std::unique_ptr<std::ofstream> m_flightOut;  //!< The flight recorder file, opened at the first dump
   std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
   std::string m_childQueueDiscMarkMsg;  //!< Reason why a packet was marked by a child queue disc
   QueueDiscSizePolicy m_sizePolicy;     //!< The queue disc size policy
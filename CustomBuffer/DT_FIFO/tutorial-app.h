@@ -50,6 +50,16 @@ public:
    */
   void Setup (Ptr<Socket> socket, Address address, uint32_t packetSize, uint32_t nPackets, DataRate dataRate);
 
+  /// \return the number of packets sent since the application started
+  uint32_t GetPacketsSent (void) const;
+
+  /**
+   * Continue from a checkpoint: count the packets sent before it, so the
+   * application sends nPackets in total. Call before the application starts.
+   * \param packetsSent the packets sent before the checkpoint
+   */
+  void SetPacketsSentAtStart (uint32_t packetsSent);
+
 private:
   virtual void StartApplication (void);
   virtual void StopApplication (void);
@@ -68,6 +78,8 @@ private:
   EventId         m_sendEvent;    //!< Send event.
   bool            m_running;      //!< True if the application is running.
   uint32_t        m_packetsSent;  //!< The number of pacts sent.
+  uint32_t        m_packetsSentAtStart; //!< The number of pacts sent before the start, from a checkpoint.
+  uint32_t        m_miceThreshold; //!< Packets per flow sent with high priority.
 };
 
 } // namespace ns3
@@ -0,0 +1,420 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+
+#include "incast-checkpoint.h"
+#include "custom_onoff-application.h"
+#include "tutorial-app.h"
+#include "customTag.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IncastCheckpoint");
+
+// version of the checkpoint file format
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+// the scalar QueueDisc::Stats fields, saved as "stat <name> <value>"
+#define CHECKPOINT_STATS_FIELDS(X)                      \
+  X (nTotalReceivedPackets)                             \
+  X (nTotalReceivedBytes)                               \
+  X (nTotalSentPackets)                                 \
+  X (nTotalSentBytes)                                   \
+  X (nTotalEnqueuedPackets)                             \
+  X (nTotalEnqueuedBytes)                               \
+  X (nTotalDequeuedPackets)                             \
+  X (nTotalDequeuedBytes)                               \
+  X (nTotalDroppedPackets)                              \
+  X (nTotalDroppedPacketsBeforeEnqueue)                 \
+  X (nTotalDroppedPacketsBeforeEnqueueHighPriority)     \
+  X (nTotalDroppedPacketsBeforeEnqueueLowPriority)      \
+  X (nTotalDroppedPacketsAfterDequeue)                  \
+  X (nTotalDroppedBytes)                                \
+  X (nTotalDroppedBytesBeforeEnqueue)                   \
+  X (nTotalDroppedBytesBeforeEnqueueHighPriority)       \
+  X (nTotalDroppedBytesBeforeEnqueueLowPriority)        \
+  X (nTotalDroppedBytesAfterDequeue)                    \
+  X (nTotalRequeuedPackets)                             \
+  X (nTotalRequeuedBytes)                               \
+  X (nTotalMarkedPackets)                               \
+  X (nTotalMarkedBytes)
+
+static std::string
+ToHex (const uint8_t *data, uint32_t size)
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string hex (2 * size, '0');
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      hex[2 * i] = digits[data[i] >> 4];
+      hex[2 * i + 1] = digits[data[i] & 0xf];
+    }
+  return hex;
+}
+
+static std::vector<uint8_t>
+FromHex (const std::string &hex)
+{
+  NS_ABORT_MSG_IF (hex.size () % 2, "Bad hex string in the checkpoint");
+  std::vector<uint8_t> data (hex.size () / 2);
+  for (uint32_t i = 0; i < data.size (); ++i)
+    {
+      data[i] = static_cast<uint8_t> (std::stoul (hex.substr (2 * i, 2), nullptr, 16));
+    }
+  return data;
+}
+
+// "<packets> <bytes> <reason>" lines of the per reason maps
+static void
+WriteReasons (std::ostream &os, const std::string &record,
+              const std::map<std::string, uint32_t, std::less<>> &packets,
+              const std::map<std::string, uint64_t, std::less<>> &bytes)
+{
+  for (const auto &p : packets)
+    {
+      auto b = bytes.find (p.first);
+      os << record << " " << p.second << " " << (b == bytes.end () ? 0 : b->second)
+         << " " << p.first << "\n";
+    }
+}
+
+static void
+ReadReasons (std::istream &is, std::map<std::string, uint32_t, std::less<>> &packets,
+             std::map<std::string, uint64_t, std::less<>> &bytes)
+{
+  uint32_t p;
+  uint64_t b;
+  std::string reason;
+  is >> p >> b >> std::ws;
+  std::getline (is, reason);
+  packets[reason] = p;
+  bytes[reason] = b;
+}
+
+IncastCheckpoint::IncastCheckpoint ()
+  : m_sinkRx (0)
+{
+}
+
+void
+IncastCheckpoint::SetScenario (const std::string &scenario)
+{
+  m_scenario = scenario;
+}
+
+void
+IncastCheckpoint::SetQueueDisc (Ptr<QueueDisc> queueDisc)
+{
+  m_queueDisc = queueDisc;
+}
+
+void
+IncastCheckpoint::AddApplication (Ptr<Application> app)
+{
+  m_apps.push_back (app);
+}
+
+void
+IncastCheckpoint::SetSink (Ptr<PacketSink> sink)
+{
+  m_sink = sink;
+}
+
+void
+IncastCheckpoint::ScheduleSave (const std::string &fileName, Time at)
+{
+  NS_ABORT_MSG_IF (!m_queueDisc, "SetQueueDisc before ScheduleSave");
+  // the queue disc can not be iterated, so its contents are followed from the start
+  m_queueDisc->TraceConnectWithoutContext ("Enqueue", MakeCallback (&IncastCheckpoint::Enqueued, this));
+  m_queueDisc->TraceConnectWithoutContext ("Dequeue", MakeCallback (&IncastCheckpoint::Dequeued, this));
+  Simulator::Schedule (at, &IncastCheckpoint::Save, this, fileName);
+}
+
+void
+IncastCheckpoint::Enqueued (Ptr<const QueueDiscItem> item)
+{
+  m_queued.push_back (item);
+}
+
+void
+IncastCheckpoint::Dequeued (Ptr<const QueueDiscItem> item)
+{
+  // FIFO, so the dequeued item is the head, but a requeued one can be behind it
+  for (auto it = m_queued.begin (); it != m_queued.end (); ++it)
+    {
+      if (*it == item)
+        {
+          m_queued.erase (it);
+          return;
+        }
+    }
+}
+
+void
+IncastCheckpoint::Save (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  std::ofstream os (fileName);
+  NS_ABORT_MSG_IF (!os, "Can not open " << fileName);
+
+  os << "incast-checkpoint " << CHECKPOINT_VERSION << "\n";
+  os << "time " << Simulator::Now ().GetNanoSeconds () << "\n";
+  os << "scenario " << m_scenario << "\n";
+  os << "rng " << RngSeedManager::GetSeed () << " " << RngSeedManager::GetRun () << "\n";
+
+  const QueueDisc::Stats &stats = m_queueDisc->GetStats ();
+#define CHECKPOINT_WRITE_STAT(field) os << "stat " #field " " << stats.field << "\n";
+  CHECKPOINT_STATS_FIELDS (CHECKPOINT_WRITE_STAT)
+#undef CHECKPOINT_WRITE_STAT
+  os << "sojournHigh";
+  for (uint32_t count : stats.sojournHistogramHighPriority)
+    {
+      os << " " << count;
+    }
+  os << "\nsojournLow";
+  for (uint32_t count : stats.sojournHistogramLowPriority)
+    {
+      os << " " << count;
+    }
+  os << "\n";
+  WriteReasons (os, "droppedBeforeEnqueue", stats.nDroppedPacketsBeforeEnqueue, stats.nDroppedBytesBeforeEnqueue);
+  WriteReasons (os, "droppedAfterDequeue", stats.nDroppedPacketsAfterDequeue, stats.nDroppedBytesAfterDequeue);
+  WriteReasons (os, "marked", stats.nMarkedPackets, stats.nMarkedBytes);
+
+  // item <age ns> <priority or -1> <protocol> <address> <src> <dst> <ip protocol> <ttl> <tos> <id> <bytes>
+  for (const Ptr<const QueueDiscItem> &qdItem : m_queued)
+    {
+      Ptr<const Ipv4QueueDiscItem> item = DynamicCast<const Ipv4QueueDiscItem> (qdItem);
+      NS_ABORT_MSG_IF (!item, "Only IPv4 packets can be saved");
+      const Ipv4Header &header = item->GetHeader ();
+      Ptr<Packet> packet = item->GetPacket ();
+      MyTag flowPrioTag;
+      int priority = packet->PeekPacketTag (flowPrioTag) ? flowPrioTag.GetSimpleValue () : -1;
+      uint8_t address[Address::MAX_SIZE];
+      uint32_t addressSize = item->GetAddress ().CopyAllTo (address, Address::MAX_SIZE);
+      std::vector<uint8_t> bytes (packet->GetSize ());
+      packet->CopyData (bytes.data (), bytes.size ());
+      os << "item " << (Simulator::Now () - item->GetTimeStamp ()).GetNanoSeconds ()
+         << " " << priority << " " << item->GetProtocol () << " " << ToHex (address, addressSize)
+         << " " << header.GetSource () << " " << header.GetDestination ()
+         << " " << static_cast<uint32_t> (header.GetProtocol ())
+         << " " << static_cast<uint32_t> (header.GetTtl ())
+         << " " << static_cast<uint32_t> (header.GetTos ())
+         << " " << header.GetIdentification ()
+         << " " << (bytes.empty () ? "-" : ToHex (bytes.data (), bytes.size ())) << "\n";
+    }
+
+  // app <sender> <bytes> <packets>
+  for (uint32_t i = 0; i < m_apps.size (); ++i)
+    {
+      if (Ptr<CustomOnOffApplication> app = DynamicCast<CustomOnOffApplication> (m_apps[i]))
+        {
+          os << "app " << i << " " << app->GetTotalBytes () << " " << app->GetPacketsSent () << "\n";
+        }
+      else if (Ptr<TutorialApp> app = DynamicCast<TutorialApp> (m_apps[i]))
+        {
+          os << "app " << i << " 0 " << app->GetPacketsSent () << "\n";
+        }
+    }
+  if (m_sink)
+    {
+      os << "sink " << m_sink->GetTotalRx () << "\n";
+    }
+  os << "end\n";
+  os.close ();
+  NS_ABORT_MSG_IF (!os, "Writing " << fileName << " failed");
+
+  std::cout << "Checkpoint at " << Simulator::Now ().GetSeconds () << " s: " << m_queued.size ()
+            << " packets queued, saved to " << fileName << std::endl;
+  Simulator::Stop ();
+}
+
+Time
+IncastCheckpoint::Load (const std::string &fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  std::ifstream in (fileName);
+  NS_ABORT_MSG_IF (!in, "Can not open " << fileName);
+
+  std::string line;
+  bool complete = false;
+  while (std::getline (in, line))
+    {
+      std::istringstream is (line);
+      std::string record;
+      is >> record;
+      if (record == "incast-checkpoint")
+        {
+          uint32_t version;
+          is >> version;
+          NS_ABORT_MSG_IF (version != CHECKPOINT_VERSION, fileName << " has version " << version
+                                                                    << ", expected " << CHECKPOINT_VERSION);
+        }
+      else if (record == "time")
+        {
+          int64_t ns;
+          is >> ns;
+          m_time = NanoSeconds (ns);
+        }
+      else if (record == "scenario")
+        {
+          std::string scenario;
+          std::getline (is >> std::ws, scenario);
+          NS_ABORT_MSG_IF (scenario != m_scenario, fileName << " was taken with\n  " << scenario
+                                                              << "\nnot with\n  " << m_scenario);
+        }
+      else if (record == "rng")
+        {
+          uint32_t seed;
+          uint64_t run;
+          is >> seed >> run;
+          if (seed != RngSeedManager::GetSeed () || run != RngSeedManager::GetRun ())
+            {
+              NS_LOG_WARN ("Checkpoint taken with RngSeed " << seed << " RngRun " << run
+                           << ", restored with " << RngSeedManager::GetSeed () << " " << RngSeedManager::GetRun ());
+            }
+        }
+      else if (record == "stat")
+        {
+          std::string field;
+          is >> field;
+#define CHECKPOINT_READ_STAT(name) if (field == #name) { is >> m_stats.name; }
+          CHECKPOINT_STATS_FIELDS (CHECKPOINT_READ_STAT)
+#undef CHECKPOINT_READ_STAT
+        }
+      else if (record == "sojournHigh" || record == "sojournLow")
+        {
+          auto &histogram = record == "sojournHigh" ? m_stats.sojournHistogramHighPriority
+                                                    : m_stats.sojournHistogramLowPriority;
+          for (uint32_t &count : histogram)
+            {
+              is >> count;
+            }
+        }
+      else if (record == "droppedBeforeEnqueue")
+        {
+          ReadReasons (is, m_stats.nDroppedPacketsBeforeEnqueue, m_stats.nDroppedBytesBeforeEnqueue);
+        }
+      else if (record == "droppedAfterDequeue")
+        {
+          ReadReasons (is, m_stats.nDroppedPacketsAfterDequeue, m_stats.nDroppedBytesAfterDequeue);
+        }
+      else if (record == "marked")
+        {
+          std::map<std::string, uint32_t, std::less<>> packets;
+          ReadReasons (is, packets, m_stats.nMarkedBytes);
+          m_stats.nMarkedPackets.insert (packets.begin (), packets.end ());
+        }
+      else if (record == "item")
+        {
+          int64_t age;
+          int priority;
+          uint16_t protocol;
+          std::string address, source, destination, bytes;
+          uint32_t ipProtocol, ttl, tos, id;
+          is >> age >> priority >> protocol >> address >> source >> destination
+             >> ipProtocol >> ttl >> tos >> id >> bytes;
+          NS_ABORT_MSG_IF (is.fail (), "Bad item in " << fileName << ": " << line);
+
+          std::vector<uint8_t> data = bytes == "-" ? std::vector<uint8_t> () : FromHex (bytes);
+          Ptr<Packet> packet = Create<Packet> (data.data (), data.size ());
+          if (priority >= 0)
+            {
+              MyTag flowPrioTag;
+              flowPrioTag.SetSimpleValue (priority);
+              packet->AddPacketTag (flowPrioTag);
+            }
+          Ipv4Header header;
+          header.SetSource (Ipv4Address (source.c_str ()));
+          header.SetDestination (Ipv4Address (destination.c_str ()));
+          header.SetProtocol (ipProtocol);
+          header.SetTtl (ttl);
+          header.SetTos (tos);
+          header.SetIdentification (id);
+          header.SetPayloadSize (packet->GetSize ());
+          Address destAddress;
+          std::vector<uint8_t> addressData = FromHex (address);
+          destAddress.CopyAllFrom (addressData.data (), addressData.size ());
+          m_items.push_back (Create<Ipv4QueueDiscItem> (packet, destAddress, protocol, header));
+          m_itemAges.push_back (NanoSeconds (age));
+        }
+      else if (record == "app")
+        {
+          uint32_t sender;
+          uint64_t bytes, packets;
+          is >> sender >> bytes >> packets;
+          m_appCounters[sender] = std::make_pair (bytes, packets);
+        }
+      else if (record == "sink")
+        {
+          is >> m_sinkRx;
+        }
+      else if (record == "end")
+        {
+          complete = true;
+        }
+    }
+  NS_ABORT_MSG_IF (!complete, fileName << " is truncated");
+  return m_time;
+}
+
+void
+IncastCheckpoint::ScheduleRestore (void)
+{
+  NS_ABORT_MSG_IF (!m_queueDisc, "SetQueueDisc before ScheduleRestore");
+  for (const auto &counters : m_appCounters)
+    {
+      NS_ABORT_MSG_IF (counters.first >= m_apps.size (), "The checkpoint has more senders than the scenario");
+      Ptr<Application> app = m_apps[counters.first];
+      if (Ptr<CustomOnOffApplication> onOff = DynamicCast<CustomOnOffApplication> (app))
+        {
+          onOff->SetSentCounters (counters.second.first, counters.second.second);
+        }
+      else if (Ptr<TutorialApp> tutorial = DynamicCast<TutorialApp> (app))
+        {
+          tutorial->SetPacketsSentAtStart (counters.second.second);
+        }
+    }
+  // scheduled before Run, so it goes before the application starts at the same time
+  Simulator::Schedule (m_time, &IncastCheckpoint::Restore, this);
+}
+
+void
+IncastCheckpoint::Restore (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_items.size (); ++i)
+    {
+      m_items[i]->SetTimeStamp (Simulator::Now () - m_itemAges[i]);
+    }
+  uint32_t dropped = m_queueDisc->RestoreCheckpoint (m_items, m_stats);
+  if (dropped)
+    {
+      NS_LOG_WARN (dropped << " restored packets did not fit in the queue disc, counted as drops");
+    }
+  m_items.clear ();
+  m_itemAges.clear ();
+}
+
+uint64_t
+IncastCheckpoint::GetSinkRxBefore (void) const
+{
+  return m_sinkRx;
+}
+
+} // namespace ns3
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "incast-topology-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("IncastTopologyHelper");
+
+IncastTopologyHelper::IncastTopologyHelper (uint32_t nSenders, const PointToPointHelper &senderLink,
+                                            const PointToPointHelper &bottleneckLink)
+  : m_nSenders (nSenders),
+    m_systemCount (1),
+    m_senderLink (senderLink),
+    m_bottleneckLink (bottleneckLink)
+{
+  NS_ASSERT_MSG (nSenders > 0, "An incast needs at least one sender");
+}
+
+void
+IncastTopologyHelper::SetSenderLink (uint32_t i, const PointToPointHelper &link)
+{
+  NS_ASSERT (i < m_nSenders);
+  m_senderLinkOverride[i] = link;
+}
+
+void
+IncastTopologyHelper::SetSystemCount (uint32_t systemCount)
+{
+  NS_ABORT_MSG_IF (m_switch, "Set the system count before Install");
+  NS_ABORT_MSG_IF (systemCount == 0, "At least one system is needed");
+  m_systemCount = systemCount;
+}
+
+void
+IncastTopologyHelper::Install (TrafficControlHelper &tch)
+{
+  NS_LOG_FUNCTION (this << m_nSenders);
+
+  // node ids: switch 0, receiver 1, senders from 2 on
+  NodeContainer core;
+  core.Create (2);
+  m_switch = core.Get (0);
+  m_receiver = core.Get (1);
+  for (uint32_t i = 0; i < m_nSenders; ++i)
+    {
+      m_senders.Create (1, i % m_systemCount);
+    }
+
+  InternetStackHelper internet;
+  internet.Install (core);
+  internet.Install (m_senders);
+
+  m_senderDevices.reserve (m_nSenders);
+  for (uint32_t i = 0; i < m_nSenders; ++i)
+    {
+      auto it = m_senderLinkOverride.find (i);
+      PointToPointHelper &link = it == m_senderLinkOverride.end () ? m_senderLink : it->second;
+      m_senderDevices.push_back (link.Install (m_senders.Get (i), m_switch));
+    }
+  m_bottleneckDevices = m_bottleneckLink.Install (m_switch, m_receiver);
+
+  // before Assign, otherwise the default root queue disc is installed
+  m_queueDiscs = tch.Install (m_bottleneckDevices);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  Ipv4StaticRoutingHelper staticRouting;
+  for (uint32_t i = 0; i < m_nSenders; ++i)
+    {
+      ipv4.NewNetwork ();
+      Ipv4InterfaceContainer ifc = ipv4.Assign (m_senderDevices[i]);
+      // everything is behind the switch
+      Ptr<Ipv4> senderIpv4 = m_senders.Get (i)->GetObject<Ipv4> ();
+      staticRouting.GetStaticRouting (senderIpv4)->SetDefaultRoute (ifc.GetAddress (1), ifc.Get (0).second);
+    }
+  ipv4.NewNetwork ();
+  m_bottleneckInterfaces = ipv4.Assign (m_bottleneckDevices);
+  Ptr<Ipv4> receiverIpv4 = m_receiver->GetObject<Ipv4> ();
+  staticRouting.GetStaticRouting (receiverIpv4)->SetDefaultRoute (m_bottleneckInterfaces.GetAddress (0),
+                                                                  m_bottleneckInterfaces.Get (1).second);
+}
+
+uint32_t
+IncastTopologyHelper::GetNSenders (void) const
+{
+  return m_nSenders;
+}
+
+Ptr<Node>
+IncastTopologyHelper::GetSender (uint32_t i) const
+{
+  return m_senders.Get (i);
+}
+
+NodeContainer
+IncastTopologyHelper::GetSenders (void) const
+{
+  return m_senders;
+}
+
+Ptr<Node>
+IncastTopologyHelper::GetSwitch (void) const
+{
+  return m_switch;
+}
+
+Ptr<Node>
+IncastTopologyHelper::GetReceiver (void) const
+{
+  return m_receiver;
+}
+
+NodeContainer
+IncastTopologyHelper::GetAllNodes (void) const
+{
+  NodeContainer all (m_switch, m_receiver);
+  all.Add (m_senders);
+  return all;
+}
+
+Ipv4Address
+IncastTopologyHelper::GetReceiverAddress (void) const
+{
+  return m_bottleneckInterfaces.GetAddress (1);
+}
+
+Ptr<NetDevice>
+IncastTopologyHelper::GetBottleneckDevice (void) const
+{
+  return m_bottleneckDevices.Get (0);
+}
+
+Ptr<QueueDisc>
+IncastTopologyHelper::GetSwitchQueueDisc (void) const
+{
+  return m_queueDiscs.Get (0);
+}
+
+} // namespace ns3
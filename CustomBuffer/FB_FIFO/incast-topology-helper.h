@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef INCAST_TOPOLOGY_HELPER_H
+#define INCAST_TOPOLOGY_HELPER_H
+
+#include <map>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+
+namespace ns3 {
+
+/**
+ * \brief Builds an N senders -> switch -> receiver incast topology.
+ *
+ * Every sender gets its own point-to-point link to the switch, and the
+ * switch reaches the receiver over one bottleneck link. The root queue disc
+ * under test is installed on the bottleneck link before addressing, so it
+ * replaces the default one.
+ *
+ * Routing is a static default route on the senders and on the receiver.
+ * The switch only needs its connected routes. No global route computation
+ * is done, so setup time grows linearly with the number of senders.
+ *
+ * For distributed (MPI) runs, see SetSystemCount, the switch and the receiver
+ * are on rank 0 and the senders are dealt round robin over all ranks, so the
+ * sender links are the partition boundaries and their delay the lookahead.
+ */
+class IncastTopologyHelper
+{
+public:
+  /**
+   * \param nSenders number of sender nodes
+   * \param senderLink link used between every sender and the switch
+   * \param bottleneckLink link between the switch and the receiver
+   */
+  IncastTopologyHelper (uint32_t nSenders, const PointToPointHelper &senderLink,
+                        const PointToPointHelper &bottleneckLink);
+
+  /**
+   * Use a different link (rate, delay, queue) for one sender.
+   * Must be called before Install.
+   * \param i the sender index
+   * \param link the link helper for that sender
+   */
+  void SetSenderLink (uint32_t i, const PointToPointHelper &link);
+
+  /**
+   * Spread the senders over several MPI ranks. Must be called before Install.
+   * \param systemCount the number of ranks (MpiInterface::GetSize)
+   */
+  void SetSystemCount (uint32_t systemCount);
+
+  /**
+   * Create the nodes, links, internet stacks, queue discs, addresses and routes.
+   * \param tch the traffic control helper with the root queue disc to install
+   *        on both ends of the bottleneck link
+   */
+  void Install (TrafficControlHelper &tch);
+
+  uint32_t GetNSenders (void) const;
+  Ptr<Node> GetSender (uint32_t i) const;
+  NodeContainer GetSenders (void) const;
+  Ptr<Node> GetSwitch (void) const;
+  Ptr<Node> GetReceiver (void) const;
+  NodeContainer GetAllNodes (void) const;
+
+  /// \return the address of the receiver on the bottleneck link
+  Ipv4Address GetReceiverAddress (void) const;
+  /// \return the switch side device of the bottleneck link
+  Ptr<NetDevice> GetBottleneckDevice (void) const;
+  /// \return the root queue disc on the switch side of the bottleneck link
+  Ptr<QueueDisc> GetSwitchQueueDisc (void) const;
+
+private:
+  uint32_t m_nSenders;
+  uint32_t m_systemCount;
+  PointToPointHelper m_senderLink;
+  PointToPointHelper m_bottleneckLink;
+  std::map<uint32_t, PointToPointHelper> m_senderLinkOverride;
+
+  NodeContainer m_senders;
+  Ptr<Node> m_switch;
+  Ptr<Node> m_receiver;
+  std::vector<NetDeviceContainer> m_senderDevices;
+  NetDeviceContainer m_bottleneckDevices;
+  Ipv4InterfaceContainer m_bottleneckInterfaces;
+  QueueDiscContainer m_queueDiscs;
+};
+
+} // namespace ns3
+
+#endif /* INCAST_TOPOLOGY_HELPER_H */
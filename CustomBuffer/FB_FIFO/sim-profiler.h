@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef SIM_PROFILER_H
+#define SIM_PROFILER_H
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+/**
+ * \brief Low overhead profile of the simulator and the queue disc hot path.
+ *
+ * Reports the simulator events processed per wall second, the packets per
+ * wall second through every QueueDisc, and an estimate of the wall time spent
+ * in each profiled section (DoEnqueue, DoDequeue, GetQueueThreshold and the
+ * queue disc trace callbacks).
+ *
+ * Only one call in 2^SampleShift of every section reads the cycle counter
+ * (rdtsc on x86, steady_clock elsewhere), the others cost an increment. The
+ * time of a section is its mean sampled time multiplied by its number of
+ * calls. Section times are inclusive: DoEnqueue includes GetQueueThreshold.
+ *
+ * Disabled by default, then a Scope costs one load and one branch. Enable
+ * before Simulator::Run; the summary is printed by Simulator::Destroy.
+ *
+ * Header only, like periodic-sampler.h, since every scenario directory has
+ * its own copy of the queue disc.
+ */
+class SimProfiler
+{
+public:
+  enum Section
+  {
+    ENQUEUE,
+    DEQUEUE,
+    THRESHOLD,
+    TRACE,
+    N_SECTIONS
+  };
+
+  static SimProfiler &
+  Get (void)
+  {
+    static SimProfiler profiler;
+    return profiler;
+  }
+
+  /**
+   * Start profiling, the wall clock starts with the first event of the run.
+   * \param sampleShift sample one call in 2^sampleShift per section
+   * \param os where the summary is printed
+   */
+  void
+  Enable (uint32_t sampleShift = 6, std::ostream *os = &std::cout)
+  {
+    m_enabled = true;
+    m_sampleMask = (1ULL << sampleShift) - 1;
+    m_os = os;
+    Simulator::ScheduleNow (&SimProfiler::MarkStart, this);
+    Simulator::ScheduleDestroy (&SimProfiler::PrintSummary, this);
+  }
+
+  bool
+  IsEnabled (void) const
+  {
+    return m_enabled;
+  }
+
+  /// \return the id the queue disc passes to CountPacket
+  uint32_t
+  AddQueueDisc (const std::string &name)
+  {
+    m_queueDiscNames.push_back (name);
+    m_queueDiscPackets.push_back (0);
+    return m_queueDiscNames.size () - 1;
+  }
+
+  void
+  CountPacket (uint32_t queueDisc)
+  {
+    m_queueDiscPackets[queueDisc]++;
+  }
+
+  static uint64_t
+  ReadCycles (void)
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc ();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds> (
+      std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+#endif
+  }
+
+  /// Profiles the enclosing block as one call of a section
+  class Scope
+  {
+  public:
+    explicit Scope (Section section)
+      : m_section (section),
+        m_start (0)
+    {
+      SimProfiler &p = Get ();
+      if (p.m_enabled && (++p.m_calls[section] & p.m_sampleMask) == 0)
+        {
+          m_start = ReadCycles ();
+        }
+    }
+
+    ~Scope ()
+    {
+      if (m_start)
+        {
+          SimProfiler &p = Get ();
+          p.m_cycles[m_section] += ReadCycles () - m_start;
+          p.m_samples[m_section]++;
+        }
+    }
+
+  private:
+    Section m_section;
+    uint64_t m_start;
+  };
+
+  void
+  PrintSummary (void)
+  {
+    if (!m_enabled || m_cyclesStart == 0)
+      {
+        // not enabled, or Simulator::Run never started
+        return;
+      }
+    double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - m_wallStart).count ();
+    double cyclesPerSecond = wall > 0 ? (ReadCycles () - m_cyclesStart) / wall : 0;
+    uint64_t events = Simulator::GetEventCount () - m_eventsStart;
+    std::ostream &os = *m_os;
+    const char *names[N_SECTIONS] = {"DoEnqueue", "DoDequeue", "GetQueueThreshold", "Trace callbacks"};
+
+    os << std::endl << "*** Simulation profile ***" << std::endl;
+    os << "  Wall time:   " << wall << " s" << std::endl;
+    os << "  Events:   " << events << std::endl;
+    os << "  Events per wall second:   " << (wall > 0 ? events / wall : 0) << std::endl;
+    os << "  Simulated time:   " << Simulator::Now ().GetSeconds () << " s" << std::endl;
+    for (uint32_t i = 0; i < m_queueDiscNames.size (); ++i)
+      {
+        if (m_queueDiscPackets[i] == 0)
+          {
+            continue;
+          }
+        os << "  Queue disc " << i << " (" << m_queueDiscNames[i] << ") packets per wall second:   "
+           << (wall > 0 ? m_queueDiscPackets[i] / wall : 0) << std::endl;
+      }
+    for (uint32_t s = 0; s < N_SECTIONS; ++s)
+      {
+        if (m_samples[s] == 0 || cyclesPerSecond == 0)
+          {
+            continue;
+          }
+        double meanSeconds = m_cycles[s] / static_cast<double> (m_samples[s]) / cyclesPerSecond;
+        double total = meanSeconds * m_calls[s];
+        os << "  " << names[s] << " time:   " << total << " s ("
+           << std::fixed << std::setprecision (1) << 100 * total / wall << "% of wall, "
+           << meanSeconds * 1e9 << " ns/call, " << m_calls[s] << " calls)"
+           << std::defaultfloat << std::setprecision (6) << std::endl;
+      }
+  }
+
+private:
+  SimProfiler ()
+    : m_enabled (false),
+      m_sampleMask (63),
+      m_os (&std::cout),
+      m_eventsStart (0),
+      m_cyclesStart (0),
+      m_calls (),
+      m_cycles (),
+      m_samples ()
+  {
+  }
+
+  void
+  MarkStart (void)
+  {
+    m_wallStart = std::chrono::steady_clock::now ();
+    m_cyclesStart = ReadCycles ();
+    m_eventsStart = Simulator::GetEventCount ();
+  }
+
+  bool m_enabled;
+  uint64_t m_sampleMask;
+  std::ostream *m_os;
+  std::chrono::steady_clock::time_point m_wallStart;
+  uint64_t m_eventsStart;
+  uint64_t m_cyclesStart;
+  uint64_t m_calls[N_SECTIONS];
+  uint64_t m_cycles[N_SECTIONS];
+  uint64_t m_samples[N_SECTIONS];
+  std::vector<std::string> m_queueDiscNames;
+  std::vector<uint64_t> m_queueDiscPackets;
+};
+
+} // namespace ns3
+
+#endif /* SIM_PROFILER_H */
@@ -28,7 +28,9 @@ TutorialApp::TutorialApp ()
     m_dataRate (0),
     m_sendEvent (),
     m_running (false),
-    m_packetsSent (0)
+    m_packetsSent (0),
+    m_packetsSentAtStart (0),
+    m_miceThreshold (10)
 {
 }
 
@@ -44,6 +46,12 @@ TypeId TutorialApp::GetTypeId (void)
     .SetParent<Application> ()
     .SetGroupName ("Tutorial")
     .AddConstructor<TutorialApp> ()
+    .AddAttribute ("MiceThreshold",
+                   "The number of packets at the start of the flow "
+                   "that are sent with high priority (mice)",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&TutorialApp::m_miceThreshold),
+                   MakeUintegerChecker<uint32_t> ())
     ;
   return tid;
 }
@@ -58,14 +66,30 @@ TutorialApp::Setup (Ptr<Socket> socket, Address address, uint32_t packetSize, ui
   m_dataRate = dataRate;
 }
 
+uint32_t
+TutorialApp::GetPacketsSent (void) const
+{
+  return m_packetsSent;
+}
+
+void
+TutorialApp::SetPacketsSentAtStart (uint32_t packetsSent)
+{
+  m_packetsSentAtStart = packetsSent;
+}
+
 void
 TutorialApp::StartApplication (void)
 {
   m_running = true;
-  m_packetsSent = 0;
+  m_packetsSent = m_packetsSentAtStart;
   m_socket->Bind ();
   m_socket->Connect (m_peer);
-  SendPacket ();
+  // nothing left to send when the checkpoint was taken after the last packet
+  if (m_packetsSentAtStart == 0 || m_packetsSent < m_nPackets)
+    {
+      SendPacket ();
+    }
 }
 
 void
@@ -92,12 +116,11 @@ TutorialApp::SendPacket (void)
   // create a tag.
   MyTag flowPrioTag;
   // set Tag value to depend on the number of previously sent packets
-  // if m_packetsSent < Threshold: TagValue->0x0 (High Priority)
-  // if m_packetsSent >= Threshold: TagValue->0x1 (Low Priority)
+  // if m_packetsSent < m_miceThreshold: TagValue->0x0 (High Priority)
+  // if m_packetsSent >= m_miceThreshold: TagValue->0x1 (Low Priority)
   
-  uint8_t Threshold = 10; // [packets], max number of packets per flow to be considered mouse flow
-
-  if (m_packetsSent < Threshold)
+  // m_miceThreshold [packets], max number of packets per flow to be considered mouse flow
+  if (m_packetsSent < m_miceThreshold)
   {
     flowPrioTag.SetSimpleValue (0x0);
   }
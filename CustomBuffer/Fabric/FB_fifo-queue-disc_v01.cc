@@ -0,0 +1,359 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 Universita' degli Studi di Napoli Federico II
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Stefano Avallone <stavallo@unina.it>
+ */
+
+#include <algorithm>
+
+#include "ns3/log.h"
+#include "FB_fifo-queue-disc_v01.h"
+#include "ns3/object-factory.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/socket.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/net-device.h"
+#include "ns3/net-device-queue-interface.h"
+#include "customTag.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FB_FifoQueueDisc_v01");
+
+NS_OBJECT_ENSURE_REGISTERED (FB_FifoQueueDisc_v01);
+
+TypeId FB_FifoQueueDisc_v01::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FB_FifoQueueDisc_v01")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FB_FifoQueueDisc_v01> ()
+    .AddAttribute ("MaxSize",
+                   "The max queue size",
+                   QueueSizeValue (QueueSize ("1000p")),
+                   MakeQueueSizeAccessor (&QueueDisc::SetMaxSize,
+                                          &QueueDisc::GetMaxSize),
+                   MakeQueueSizeChecker ())
+    .AddAttribute ("AlphaHigh",
+                   "The alpha of the high priority packets",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&FB_FifoQueueDisc_v01::m_alpha_h),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("AlphaLow",
+                   "The alpha of the low priority packets",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&FB_FifoQueueDisc_v01::m_alpha_l),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("Gamma",
+                   "The normalized de-queue rate of the port",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&FB_FifoQueueDisc_v01::m_gamma),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("NumClasses",
+                   "The total number of priority classes, at most 2 (high and low)",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&FB_FifoQueueDisc_v01::m_numClasses),
+                   MakeUintegerChecker<uint32_t> (1, 2))
+    .AddAttribute ("EstimateGamma",
+                   "Replace Gamma by the measured dequeue rate of every class over the port rate",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FB_FifoQueueDisc_v01::m_estimateGamma),
+                   MakeBooleanChecker ())
+    .AddAttribute ("GammaWindow",
+                   "The busy time over which the dequeue rates are measured before they enter the average",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&FB_FifoQueueDisc_v01::m_gammaWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("GammaWeight",
+                   "The weight of the last window in the average dequeue rates",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&FB_FifoQueueDisc_v01::m_gammaWeight),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("GammaMin",
+                   "The smallest estimated gamma, so that a class that is not dequeued can still enqueue",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&FB_FifoQueueDisc_v01::m_gammaMin),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("PortRate",
+                   "The rate the dequeue rates are normalized to, 0 for the DataRate of the device",
+                   DataRateValue (DataRate (0)),
+                   MakeDataRateAccessor (&FB_FifoQueueDisc_v01::m_portRate),
+                   MakeDataRateChecker ())
+  ;
+  return tid;
+}
+
+FB_FifoQueueDisc_v01::FB_FifoQueueDisc_v01 ()
+  : QueueDisc (QueueDiscSizePolicy::SINGLE_INTERNAL_QUEUE)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FB_FifoQueueDisc_v01::~FB_FifoQueueDisc_v01 ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+FB_FifoQueueDisc_v01::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  
+  uint32_t alphaFp;
+  
+  // // set a besic Packet clasification based on packet size:
+  // uint32_t Packet_Size_Threshold = 60; // define a packet size [bytes] threshold to assign to different alphas.
+  // // for packets < Packet_Size_Threshold, assign high priority -> alpha = alpha_h
+  // // for packets >= Packet_Size_Threshold, assign low priority -> alpha = alpha_l
+  // if (item->GetSize () < Packet_Size_Threshold)
+  //   {
+  //     alpha = alpha_h;
+  //   }
+  // else
+  //   {
+  //     alpha = alpha_l; 
+  //   }
+
+  // set a besic Packet clasification based on arbitrary Tag from recieved packet:
+  // flow_priority = 0 is high priority, flow_priority = 1 is low priority
+  uint8_t flow_priority = 0;
+  MyTag flowPrioTag;
+  if (item->GetPacket ()->PeekPacketTag (flowPrioTag))
+    {
+      flow_priority = flowPrioTag.GetSimpleValue();
+    }
+  
+  if (flow_priority == 0)
+    {
+      alphaFp = m_alphaFp_h;
+    }
+  else
+    {
+      alphaFp = m_alphaFp_l;
+    }
+
+
+  // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
+  // internal queue because QueueDisc::AddInternalQueue sets the trace callback
+
+
+
+  // if (GetCurrentSize () + item > GetMaxSize ())
+  if ((GetCurrentSize () + item > GetQueueThreshold (flow_priority, alphaFp)) or (GetCurrentSize () + item > GetMaxSize ()))
+    {
+      // NS_LOG_LOGIC ("Queue full -- dropping pkt");
+      NS_LOG_LOGIC ("Queue exceeds threshold -- dropping pkt");
+      DropBeforeEnqueue (item, LIMIT_EXCEEDED_DROP);
+      return false;
+    }
+
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+  
+  // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
+  // internal queue because QueueDisc::AddInternalQueue sets the trace callback
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  //////////////////Added by me///////////////////////
+  // NS_LOG_LOGIC ("Number High Priority packets " << GetInternalQueue (0)->GetNPacketsHigh ());
+  // NS_LOG_LOGIC ("Number Low Priority packets " << GetInternalQueue (0)->GetNPacketsLow ());
+  ///////////////////////////////////////////////////////////
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+  NS_LOG_LOGIC ("Enqueue Threshold " << GetQueueThreshold (flow_priority, alphaFp));
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+FB_FifoQueueDisc_v01::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<QueueDiscItem> item = GetInternalQueue (0)->Dequeue ();
+
+  if (!item)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  if (m_estimateGamma)
+    {
+      UpdateDequeueRate (item);
+    }
+
+  return item;
+}
+
+void
+FB_FifoQueueDisc_v01::UpdateDequeueRate (Ptr<const QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  Time now = Simulator::Now ();
+  if (!m_busy)
+    {
+      m_busy = true;
+      m_busyStart = now;
+    }
+  MyTag flowPrioTag;
+  uint8_t c = item->GetPacket ()->PeekPacketTag (flowPrioTag) && flowPrioTag.GetSimpleValue () != 0 ? 1 : 0;
+  m_windowBytes[c] += item->GetSize ();
+
+  // the busy period runs from its first dequeue to the end of the
+  // transmission of its last packet, the time until the next dequeue is idle
+  double portRate = GetPortRate ();
+  Time busy = m_busyTime + (now - m_busyStart);
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      if (portRate > 0)
+        {
+          busy += Seconds (item->GetSize () * 8.0 / portRate);
+        }
+      m_busyTime = busy;
+      m_busy = false;
+    }
+  if (busy < m_gammaWindow || !busy.IsStrictlyPositive ())
+    {
+      return;
+    }
+
+  double seconds = busy.GetSeconds ();
+  for (uint32_t i = 0; i < 2; ++i)
+    {
+      double rate = m_windowBytes[i] * 8.0 / seconds;
+      m_dequeueRate[i] = m_rateValid ? (1 - m_gammaWeight) * m_dequeueRate[i] + m_gammaWeight * rate : rate;
+      m_windowBytes[i] = 0;
+      if (portRate > 0)
+        {
+          m_gammaFpClass[i] = AlphaToFixedPoint (std::max (m_gammaMin, std::min (1.0, m_dequeueRate[i] / portRate)));
+        }
+    }
+  m_rateValid = true;
+  m_busyTime = Seconds (0);
+  m_busyStart = now;
+  NS_LOG_LOGIC ("Dequeue rates " << m_dequeueRate[0] << " " << m_dequeueRate[1] << " bit/s, gamma "
+                << m_gammaFpClass[0] / double (1 << ALPHA_SHIFT) << " "
+                << m_gammaFpClass[1] / double (1 << ALPHA_SHIFT));
+}
+
+double
+FB_FifoQueueDisc_v01::GetPortRate (void)
+{
+  if (m_portRateBps == 0)
+    {
+      m_portRateBps = m_portRate.GetBitRate ();
+    }
+  if (m_portRateBps == 0)
+    {
+      // the NetDeviceQueueInterface is aggregated to the device
+      Ptr<NetDeviceQueueInterface> ndqi = GetNetDeviceQueueInterface ();
+      Ptr<NetDevice> device = ndqi ? ndqi->GetObject<NetDevice> () : 0;
+      DataRateValue rate;
+      if (device && device->GetAttributeFailSafe ("DataRate", rate))
+        {
+          m_portRateBps = rate.Get ().GetBitRate ();
+        }
+      else if (!m_portRateWarned)
+        {
+          NS_LOG_WARN ("No port rate to normalize the dequeue rates to, gamma stays " << m_gamma);
+          m_portRateWarned = true;
+        }
+    }
+  return m_portRateBps;
+}
+
+Ptr<const QueueDiscItem>
+FB_FifoQueueDisc_v01::DoPeek (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<const QueueDiscItem> item = GetInternalQueue (0)->Peek ();
+
+  if (!item)
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  return item;
+}
+
+bool
+FB_FifoQueueDisc_v01::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("FifoQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("FifoQueueDisc needs no packet filter");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // add a DropTail queue
+      AddInternalQueue (CreateObjectWithAttributes<DropTailQueue<QueueDiscItem> >
+                          ("MaxSize", QueueSizeValue (GetMaxSize ())));
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("FifoQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  return true;
+}
+
+void
+FB_FifoQueueDisc_v01::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+  // the enqueue path only uses the fixed point values
+  m_alphaFp_h = AlphaToFixedPoint (m_alpha_h);
+  m_alphaFp_l = AlphaToFixedPoint (m_alpha_l);
+  m_gammaFp = AlphaToFixedPoint (m_gamma);
+  // until the first window ends the estimate is the configured gamma
+  m_gammaFpClass[0] = m_gammaFpClass[1] = m_gammaFp;
+  m_windowBytes[0] = m_windowBytes[1] = 0;
+  m_dequeueRate[0] = m_dequeueRate[1] = 0;
+  m_rateValid = false;
+  m_busy = false;
+  m_busyTime = Seconds (0);
+  m_portRateBps = 0;
+  m_portRateWarned = false;
+}
+
+uint32_t
+FB_FifoQueueDisc_v01::GetThresholdFactor (uint8_t priority)
+{
+  // FB: T_c(t) = alpha_c * (1 - N_congested(t)/N_classes) * gamma_c * (B - Q(t))
+  // N_congested/N_classes is an integer division, as it always was, so the
+  // factor is gamma_c until every class is congested, and then 0
+  uint32_t gammaFp = m_estimateGamma ? m_gammaFpClass[priority == 0 ? 0 : 1] : m_gammaFp;
+  uint32_t nCongested = GetNCongestedClasses ();
+  return nCongested < m_numClasses ? gammaFp : 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2017 Universita' degli Studi di Napoli Federico II
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Stefano Avallone <stavallo@unina.it>
+ */
+
+#ifndef FB_FIFO_QUEUE_DISC_V01_H
+#define FB_FIFO_QUEUE_DISC_V01_H
+
+#include "queue-disc.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * Simple queue disc implementing the FIFO (First-In First-Out) policy.
+ *
+ */
+// class FB_FifoQueueDisc_v01 : public CustomeQueueDisc {
+class FB_FifoQueueDisc_v01 : public QueueDisc {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief FifoQueueDisc constructor
+   *
+   * Creates a queue with a depth of 1000 packets by default
+   */
+  FB_FifoQueueDisc_v01 ();
+
+  virtual ~FB_FifoQueueDisc_v01();
+
+  // Reasons for dropping packets
+  static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded";  //!< Packet dropped due to queue disc limit exceeded
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void);
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  /**
+   * \brief Update the dequeue rate of the class of a dequeued item
+   *
+   * The bytes of every class are counted over windows of GammaWindow of
+   * busy time, in simulation time from the first dequeue of a busy period
+   * to the last one plus the transmission time of that packet at the port
+   * rate, so a port that drains slower than the port rate gives lower rates
+   * and the time the queue is empty is left out. At the end of a window the
+   * rate of every class enters an EWMA and gamma_c becomes that average over
+   * the port rate, clamped to [GammaMin, 1]; while the port rate is unknown
+   * gamma_c stays Gamma. O(1) per dequeue.
+   * \param item the dequeued item
+   */
+  void UpdateDequeueRate (Ptr<const QueueDiscItem> item);
+
+  /**
+   * \return the rate [bit/s] the dequeue rates are normalized to, the
+   *         PortRate attribute or else the DataRate of the device, 0 if unknown
+   */
+  double GetPortRate (void);
+
+  double m_alpha_h;        //!< alpha of the high priority packets
+  double m_alpha_l;        //!< alpha of the low priority packets
+  uint32_t m_alphaFp_h;    //!< m_alpha_h in fixed point, set by InitializeParams
+  uint32_t m_alphaFp_l;    //!< m_alpha_l in fixed point, set by InitializeParams
+  double m_gamma;          //!< normalized de-queue rate of the port
+  uint32_t m_gammaFp;      //!< m_gamma in fixed point, set by InitializeParams
+  uint32_t m_numClasses;   //!< total number of priority classes
+  virtual uint32_t GetThresholdFactor (uint8_t priority);
+
+  // gamma_c estimated from the dequeue rate of every class
+  bool m_estimateGamma;          //!< use the estimated gamma_c instead of m_gamma
+  Time m_gammaWindow;            //!< busy time over which a rate is measured
+  double m_gammaWeight;          //!< EWMA weight of the last window
+  double m_gammaMin;             //!< lower bound of the estimated gamma_c
+  DataRate m_portRate;           //!< rate the dequeue rates are normalized to, 0 for the device one
+  double m_portRateBps;          //!< the port rate in use [bit/s], 0 until known
+  bool m_portRateWarned;         //!< whether the unknown port rate has been logged
+  uint64_t m_windowBytes[2];     //!< bytes dequeued per class in the current window
+  Time m_busyTime;               //!< busy time of the current window before m_busyStart
+  Time m_busyStart;              //!< start of the current busy period
+  bool m_busy;                   //!< whether the queue has been non empty since m_busyStart
+  bool m_rateValid;              //!< whether m_dequeueRate holds a first window
+  double m_dequeueRate[2];       //!< EWMA of the dequeue rate per class [bit/s]
+  uint32_t m_gammaFpClass[2];    //!< the estimated gamma_c in fixed point
+};
+
+} // namespace ns3
+
+#endif /* FB_FIFO_QUEUE_DISC_V01_H */
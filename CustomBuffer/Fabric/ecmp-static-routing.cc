@@ -0,0 +1,251 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+
+#include "ecmp-static-routing.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EcmpStaticRouting");
+
+NS_OBJECT_ENSURE_REGISTERED (EcmpStaticRouting);
+
+namespace {
+
+// finalizer of MurmurHash3, mixes all input bits into all output bits
+uint32_t
+Mix (uint32_t h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+uint32_t
+PrefixLength (uint32_t mask)
+{
+  uint32_t len = 0;
+  while (mask & 0x80000000)
+    {
+      len++;
+      mask <<= 1;
+    }
+  return len;
+}
+
+} // namespace
+
+TypeId
+EcmpStaticRouting::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EcmpStaticRouting")
+    .SetParent<Ipv4RoutingProtocol> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<EcmpStaticRouting> ()
+  ;
+  return tid;
+}
+
+EcmpStaticRouting::EcmpStaticRouting ()
+  : m_ipv4 (0),
+    m_seed (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EcmpStaticRouting::~EcmpStaticRouting ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+EcmpStaticRouting::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ipv4 = 0;
+  m_routes.clear ();
+  Ipv4RoutingProtocol::DoDispose ();
+}
+
+void
+EcmpStaticRouting::AddRoute (Ipv4Address network, Ipv4Mask mask,
+                             const std::vector<uint32_t> &interfaces,
+                             const std::vector<Ipv4Address> &gateways)
+{
+  NS_LOG_FUNCTION (this << network << mask);
+  NS_ASSERT (!interfaces.empty () && interfaces.size () == gateways.size ());
+
+  Entry entry;
+  entry.network = network.CombineMask (mask).Get ();
+  entry.mask = mask.Get ();
+  for (uint32_t i = 0; i < interfaces.size (); ++i)
+    {
+      NextHop hop;
+      hop.interface = interfaces[i];
+      hop.gateway = gateways[i];
+      entry.nextHops.push_back (hop);
+    }
+
+  // keep the table sorted by decreasing prefix length, so the first match is the longest
+  auto it = m_routes.begin ();
+  while (it != m_routes.end () && PrefixLength (it->mask) >= PrefixLength (entry.mask))
+    {
+      ++it;
+    }
+  m_routes.insert (it, entry);
+}
+
+uint32_t
+EcmpStaticRouting::GetNRoutes (void) const
+{
+  return m_routes.size ();
+}
+
+uint32_t
+EcmpStaticRouting::FlowHash (const Ipv4Header &header, Ptr<const Packet> p) const
+{
+  uint32_t h = m_seed;
+  h = Mix (h ^ header.GetSource ().Get ());
+  h = Mix (h ^ header.GetDestination ().Get ());
+  h = Mix (h ^ header.GetProtocol ());
+  // TCP and UDP start with the source and destination ports
+  uint8_t protocol = header.GetProtocol ();
+  if (p && (protocol == 6 || protocol == 17) && p->GetSize () >= 4)
+    {
+      uint8_t ports[4];
+      p->CopyData (ports, 4);
+      h = Mix (h ^ ((uint32_t)ports[0] << 24 | (uint32_t)ports[1] << 16 | (uint32_t)ports[2] << 8 | ports[3]));
+    }
+  return h;
+}
+
+Ptr<Ipv4Route>
+EcmpStaticRouting::Lookup (const Ipv4Header &header, Ptr<const Packet> p) const
+{
+  uint32_t dst = header.GetDestination ().Get ();
+  for (const Entry &entry : m_routes)
+    {
+      if ((dst & entry.mask) != entry.network)
+        {
+          continue;
+        }
+      const NextHop &hop = entry.nextHops.size () == 1
+        ? entry.nextHops[0]
+        : entry.nextHops[FlowHash (header, p) % entry.nextHops.size ()];
+      Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+      route->SetDestination (header.GetDestination ());
+      route->SetGateway (hop.gateway);
+      route->SetSource (m_ipv4->GetAddress (hop.interface, 0).GetLocal ());
+      route->SetOutputDevice (m_ipv4->GetNetDevice (hop.interface));
+      return route;
+    }
+  return 0;
+}
+
+Ptr<Ipv4Route>
+EcmpStaticRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
+                                Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
+{
+  NS_LOG_FUNCTION (this << header << oif);
+  // sockets hand over the payload without the transport header, so only the addresses are hashed
+  Ptr<Ipv4Route> route = Lookup (header, 0);
+  if (route && oif && route->GetOutputDevice () != oif)
+    {
+      route = 0;
+    }
+  sockerr = route ? Socket::ERROR_NOTERROR : Socket::ERROR_NOROUTETOHOST;
+  return route;
+}
+
+bool
+EcmpStaticRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
+                               UnicastForwardCallback ucb, MulticastForwardCallback mcb,
+                               LocalDeliverCallback lcb, ErrorCallback ecb)
+{
+  NS_LOG_FUNCTION (this << p << header << idev);
+  if (header.GetDestination ().IsMulticast () || header.GetDestination ().IsBroadcast ())
+    {
+      return false;
+    }
+  // the IPv4 header has already been removed, p starts with the transport header
+  Ptr<Ipv4Route> route = Lookup (header, p);
+  if (!route)
+    {
+      return false;
+    }
+  ucb (route, p, header);
+  return true;
+}
+
+void
+EcmpStaticRouting::NotifyInterfaceUp (uint32_t interface)
+{
+}
+
+void
+EcmpStaticRouting::NotifyInterfaceDown (uint32_t interface)
+{
+}
+
+void
+EcmpStaticRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+EcmpStaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+EcmpStaticRouting::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  NS_LOG_FUNCTION (this << ipv4);
+  NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
+  m_ipv4 = ipv4;
+  Ptr<Node> node = ipv4->GetObject<Node> ();
+  m_seed = Mix (node ? node->GetId () + 1 : 1);
+}
+
+void
+EcmpStaticRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+  std::ostream *os = stream->GetStream ();
+  *os << "Node: " << m_ipv4->GetObject<Node> ()->GetId ()
+      << ", Time: " << Now ().As (unit)
+      << ", EcmpStaticRouting table" << std::endl;
+  *os << "Destination     Mask            Next hops (gateway/interface)" << std::endl;
+  for (const Entry &entry : m_routes)
+    {
+      std::ostringstream dst, mask;
+      dst << Ipv4Address (entry.network);
+      mask << Ipv4Mask (entry.mask);
+      *os << std::setiosflags (std::ios::left) << std::setw (16) << dst.str ()
+          << std::setw (16) << mask.str ();
+      for (const NextHop &hop : entry.nextHops)
+        {
+          *os << " " << hop.gateway << "/" << hop.interface;
+        }
+      *os << std::endl;
+    }
+  *os << std::endl;
+}
+
+} // namespace ns3
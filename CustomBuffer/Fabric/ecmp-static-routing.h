@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ECMP_STATIC_ROUTING_H
+#define ECMP_STATIC_ROUTING_H
+
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+namespace ns3 {
+
+/**
+ * \brief Static routing with hash based equal cost multipath.
+ *
+ * Every route is a prefix with one or more next hops. A packet takes the
+ * longest matching prefix, and among its next hops the one picked by a hash
+ * of the 5-tuple, so all packets of a flow follow the same path. The hash is
+ * seeded per node so that the tiers of a fabric do not make correlated
+ * choices.
+ *
+ * It is meant to be added to the Ipv4ListRouting of a node with a lower
+ * priority than Ipv4StaticRouting, which keeps handling the connected
+ * networks.
+ */
+class EcmpStaticRouting : public Ipv4RoutingProtocol
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  EcmpStaticRouting ();
+  virtual ~EcmpStaticRouting ();
+
+  /**
+   * \brief Add a route to a prefix over several equal cost next hops
+   * \param network the destination network
+   * \param mask the network mask
+   * \param interfaces the output interface of every next hop
+   * \param gateways the gateway of every next hop
+   */
+  void AddRoute (Ipv4Address network, Ipv4Mask mask,
+                 const std::vector<uint32_t> &interfaces,
+                 const std::vector<Ipv4Address> &gateways);
+
+  /// \return the number of prefixes in the table
+  uint32_t GetNRoutes (void) const;
+
+  // Functions defined in Ipv4RoutingProtocol
+  virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header,
+                                      Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
+  virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
+                           UnicastForwardCallback ucb, MulticastForwardCallback mcb,
+                           LocalDeliverCallback lcb, ErrorCallback ecb);
+  virtual void NotifyInterfaceUp (uint32_t interface);
+  virtual void NotifyInterfaceDown (uint32_t interface);
+  virtual void NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address);
+  virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
+  virtual void SetIpv4 (Ptr<Ipv4> ipv4);
+  virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// One next hop of a route
+  struct NextHop
+  {
+    uint32_t interface;   //!< output interface
+    Ipv4Address gateway;  //!< next hop address
+  };
+
+  /// A prefix and its equal cost next hops
+  struct Entry
+  {
+    uint32_t network;     //!< network address, host order
+    uint32_t mask;        //!< network mask, host order
+    std::vector<NextHop> nextHops;
+  };
+
+  /**
+   * \param header the IPv4 header
+   * \param p the packet without the IPv4 header, may be 0
+   * \return the route for the packet, 0 if there is none
+   */
+  Ptr<Ipv4Route> Lookup (const Ipv4Header &header, Ptr<const Packet> p) const;
+
+  /// Flow hash of the 5-tuple; the ports are read from the first 4 bytes of p
+  uint32_t FlowHash (const Ipv4Header &header, Ptr<const Packet> p) const;
+
+  Ptr<Ipv4> m_ipv4;
+  uint32_t m_seed;
+  std::vector<Entry> m_routes;  //!< sorted by decreasing prefix length
+};
+
+} // namespace ns3
+
+#endif /* ECMP_STATIC_ROUTING_H */
@@ -0,0 +1,432 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fabric-topology-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FabricTopologyHelper");
+
+FabricTopologyHelper::FabricTopologyHelper (const PointToPointHelper &hostLink,
+                                            const PointToPointHelper &fabricLink)
+  : m_hostLink (hostLink),
+    m_fabricLink (fabricLink),
+    m_systemCount (1)
+{
+  Reset ();
+}
+
+void
+FabricTopologyHelper::SetSystemCount (uint32_t systemCount)
+{
+  NS_ABORT_MSG_IF (m_type != NONE, "Set the system count before building the fabric");
+  NS_ABORT_MSG_IF (systemCount == 0, "At least one system is needed");
+  m_systemCount = systemCount;
+}
+
+void
+FabricTopologyHelper::Reset (void)
+{
+  m_type = NONE;
+  m_k = 0;
+  m_hostsPerEdge = 0;
+  m_edgeUplinks = 0;
+  m_aggUplinks = 0;
+}
+
+NetDeviceContainer
+FabricTopologyHelper::InstallHostLink (Ptr<Node> edge, Ptr<Node> host)
+{
+  NetDeviceContainer devs = m_hostLink.Install (edge, host);
+  m_switchPorts.Add (devs.Get (0));
+  return devs;
+}
+
+NetDeviceContainer
+FabricTopologyHelper::InstallFabricLink (Ptr<Node> lower, Ptr<Node> upper)
+{
+  NetDeviceContainer devs = m_fabricLink.Install (lower, upper);
+  m_switchPorts.Add (devs);
+  return devs;
+}
+
+void
+FabricTopologyHelper::InstallFatTree (uint32_t k, TrafficControlHelper &tch)
+{
+  NS_LOG_FUNCTION (this << k);
+  NS_ABORT_MSG_IF (m_type != NONE, "The fabric has already been built");
+  NS_ABORT_MSG_IF (k < 2 || k % 2 != 0 || k > 128, "The fat-tree radix must be even and at most 128");
+
+  uint32_t half = k / 2;
+  m_type = FAT_TREE;
+  m_k = k;
+  m_hostsPerEdge = half;
+  m_edgeUplinks = half;
+  m_aggUplinks = half;
+
+  // a pod stays on one rank
+  for (uint32_t h = 0; h < k * half * half; ++h)
+    {
+      m_hosts.Create (1, (h / (half * half)) % m_systemCount);
+    }
+  for (uint32_t e = 0; e < k * half; ++e)
+    {
+      m_edges.Create (1, (e / half) % m_systemCount);
+    }
+  for (uint32_t a = 0; a < k * half; ++a)
+    {
+      m_aggs.Create (1, (a / half) % m_systemCount);
+    }
+  for (uint32_t c = 0; c < half * half; ++c)
+    {
+      m_cores.Create (1, c % m_systemCount);
+    }
+
+  InternetStackHelper internet;
+  internet.Install (GetAllNodes ());
+
+  m_hostLinks.reserve (m_hosts.GetN ());
+  for (uint32_t h = 0; h < m_hosts.GetN (); ++h)
+    {
+      m_hostLinks.push_back (InstallHostLink (m_edges.Get (h / half), m_hosts.Get (h)));
+    }
+  // every edge switch connects to every aggregation switch of its pod
+  m_edgeUplinkDevs.reserve (m_edges.GetN () * half);
+  for (uint32_t e = 0; e < m_edges.GetN (); ++e)
+    {
+      uint32_t pod = e / half;
+      for (uint32_t j = 0; j < half; ++j)
+        {
+          m_edgeUplinkDevs.push_back (InstallFabricLink (m_edges.Get (e), m_aggs.Get (pod * half + j)));
+        }
+    }
+  // aggregation switch j of every pod connects to core switches j*k/2 .. (j+1)*k/2-1
+  m_aggUplinkDevs.reserve (m_aggs.GetN () * half);
+  for (uint32_t a = 0; a < m_aggs.GetN (); ++a)
+    {
+      for (uint32_t j = 0; j < half; ++j)
+        {
+          m_aggUplinkDevs.push_back (InstallFabricLink (m_aggs.Get (a), m_cores.Get ((a % half) * half + j)));
+        }
+    }
+
+  // before the addresses, otherwise the default root queue disc is installed
+  m_queueDiscs = tch.Install (m_switchPorts);
+  AssignAddresses (half);
+}
+
+void
+FabricTopologyHelper::InstallLeafSpine (uint32_t nLeaves, uint32_t nSpines, uint32_t hostsPerLeaf,
+                                        TrafficControlHelper &tch)
+{
+  NS_LOG_FUNCTION (this << nLeaves << nSpines << hostsPerLeaf);
+  NS_ABORT_MSG_IF (m_type != NONE, "The fabric has already been built");
+  NS_ABORT_MSG_IF (nLeaves == 0 || nSpines == 0 || hostsPerLeaf == 0, "Empty leaf-spine fabric");
+  NS_ABORT_MSG_IF (hostsPerLeaf > 64, "At most 64 hosts fit in the /24 of a leaf");
+  NS_ABORT_MSG_IF (nLeaves > 256 * 256, "Too many leaves for the 10.0.0.0/8 host range");
+
+  m_type = LEAF_SPINE;
+  m_hostsPerEdge = hostsPerLeaf;
+  m_edgeUplinks = nSpines;
+
+  // a leaf and its hosts stay on one rank
+  for (uint32_t h = 0; h < nLeaves * hostsPerLeaf; ++h)
+    {
+      m_hosts.Create (1, (h / hostsPerLeaf) % m_systemCount);
+    }
+  for (uint32_t l = 0; l < nLeaves; ++l)
+    {
+      m_edges.Create (1, l % m_systemCount);
+    }
+  for (uint32_t sp = 0; sp < nSpines; ++sp)
+    {
+      m_cores.Create (1, sp % m_systemCount);
+    }
+
+  InternetStackHelper internet;
+  internet.Install (GetAllNodes ());
+
+  m_hostLinks.reserve (m_hosts.GetN ());
+  for (uint32_t h = 0; h < m_hosts.GetN (); ++h)
+    {
+      m_hostLinks.push_back (InstallHostLink (m_edges.Get (h / hostsPerLeaf), m_hosts.Get (h)));
+    }
+  m_edgeUplinkDevs.reserve (nLeaves * nSpines);
+  for (uint32_t l = 0; l < nLeaves; ++l)
+    {
+      for (uint32_t s = 0; s < nSpines; ++s)
+        {
+          m_edgeUplinkDevs.push_back (InstallFabricLink (m_edges.Get (l), m_cores.Get (s)));
+        }
+    }
+
+  m_queueDiscs = tch.Install (m_switchPorts);
+  AssignAddresses (256);
+}
+
+void
+FabricTopologyHelper::AssignAddresses (uint32_t edgesPerPod)
+{
+  Ipv4AddressHelper ipv4;
+  Ipv4Mask linkMask ("255.255.255.252");
+
+  m_hostAddresses.reserve (m_hosts.GetN ());
+  for (uint32_t h = 0; h < m_hosts.GetN (); ++h)
+    {
+      uint32_t edge = h / m_hostsPerEdge;
+      uint32_t pod = edge / edgesPerPod;
+      uint32_t i = h % m_hostsPerEdge;
+      uint32_t net = (10u << 24) | (pod << 16) | ((edge % edgesPerPod) << 8) | (4 * i);
+      ipv4.SetBase (Ipv4Address (net), linkMask);
+      Ipv4InterfaceContainer ifc = ipv4.Assign (m_hostLinks[h]);
+      m_hostAddresses.push_back (ifc.GetAddress (1));
+    }
+
+  uint32_t net = Ipv4Address ("172.16.0.0").Get ();
+  for (auto &devs : m_edgeUplinkDevs)
+    {
+      ipv4.SetBase (Ipv4Address (net), linkMask);
+      ipv4.Assign (devs);
+      net += 4;
+    }
+  for (auto &devs : m_aggUplinkDevs)
+    {
+      ipv4.SetBase (Ipv4Address (net), linkMask);
+      ipv4.Assign (devs);
+      net += 4;
+    }
+  NS_ABORT_MSG_IF (net > Ipv4Address ("172.31.255.255").Get (), "Too many fabric links for 172.16.0.0/12");
+}
+
+Ptr<EcmpStaticRouting>
+FabricTopologyHelper::AddEcmpRouting (Ptr<Node> node)
+{
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+  NS_ABORT_MSG_IF (!list, "EcmpStaticRouting needs the Ipv4ListRouting of the InternetStackHelper");
+  Ptr<EcmpStaticRouting> ecmp = CreateObject<EcmpStaticRouting> ();
+  // below Ipv4StaticRouting (0), which keeps the connected networks
+  list->AddRoutingProtocol (ecmp, -5);
+  return ecmp;
+}
+
+void
+FabricTopologyHelper::AddNextHop (const NetDeviceContainer &link, uint32_t dev,
+                                  std::vector<uint32_t> &interfaces, std::vector<Ipv4Address> &gateways)
+{
+  Ptr<NetDevice> near = link.Get (dev);
+  Ptr<NetDevice> far = link.Get (1 - dev);
+  Ptr<Ipv4> nearIpv4 = near->GetNode ()->GetObject<Ipv4> ();
+  Ptr<Ipv4> farIpv4 = far->GetNode ()->GetObject<Ipv4> ();
+  interfaces.push_back (nearIpv4->GetInterfaceForDevice (near));
+  gateways.push_back (farIpv4->GetAddress (farIpv4->GetInterfaceForDevice (far), 0).GetLocal ());
+}
+
+void
+FabricTopologyHelper::InstallEcmpRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_type == NONE, "Build the fabric before installing the routes");
+
+  Ipv4Address any ("0.0.0.0");
+  Ipv4Mask anyMask ("0.0.0.0");
+  Ipv4Mask edgeMask ("255.255.255.0");
+  Ipv4Mask podMask ("255.255.0.0");
+  Ipv4StaticRoutingHelper staticRouting;
+
+  for (uint32_t h = 0; h < m_hosts.GetN (); ++h)
+    {
+      std::vector<uint32_t> interfaces;
+      std::vector<Ipv4Address> gateways;
+      AddNextHop (m_hostLinks[h], 1, interfaces, gateways);
+      Ptr<Ipv4> ipv4 = m_hosts.Get (h)->GetObject<Ipv4> ();
+      staticRouting.GetStaticRouting (ipv4)->SetDefaultRoute (gateways[0], interfaces[0]);
+    }
+
+  // everything outside the edge/leaf switch goes up
+  for (uint32_t e = 0; e < m_edges.GetN (); ++e)
+    {
+      std::vector<uint32_t> interfaces;
+      std::vector<Ipv4Address> gateways;
+      for (uint32_t j = 0; j < m_edgeUplinks; ++j)
+        {
+          AddNextHop (GetEdgeUplink (e, j), 0, interfaces, gateways);
+        }
+      AddEcmpRouting (m_edges.Get (e))->AddRoute (any, anyMask, interfaces, gateways);
+    }
+
+  if (m_type == FAT_TREE)
+    {
+      uint32_t half = m_k / 2;
+      for (uint32_t a = 0; a < m_aggs.GetN (); ++a)
+        {
+          Ptr<EcmpStaticRouting> ecmp = AddEcmpRouting (m_aggs.Get (a));
+          uint32_t pod = a / half;
+          // down to every edge switch of the pod, agg a is uplink a%half of each of them
+          for (uint32_t e = 0; e < half; ++e)
+            {
+              std::vector<uint32_t> interfaces;
+              std::vector<Ipv4Address> gateways;
+              AddNextHop (GetEdgeUplink (pod * half + e, a % half), 1, interfaces, gateways);
+              ecmp->AddRoute (Ipv4Address ((10u << 24) | (pod << 16) | (e << 8)), edgeMask, interfaces, gateways);
+            }
+          std::vector<uint32_t> interfaces;
+          std::vector<Ipv4Address> gateways;
+          for (uint32_t j = 0; j < half; ++j)
+            {
+              AddNextHop (GetAggregationUplink (a, j), 0, interfaces, gateways);
+            }
+          ecmp->AddRoute (any, anyMask, interfaces, gateways);
+        }
+      // core c is uplink c%half of aggregation switch c/half of every pod
+      for (uint32_t c = 0; c < m_cores.GetN (); ++c)
+        {
+          Ptr<EcmpStaticRouting> ecmp = AddEcmpRouting (m_cores.Get (c));
+          for (uint32_t pod = 0; pod < m_k; ++pod)
+            {
+              std::vector<uint32_t> interfaces;
+              std::vector<Ipv4Address> gateways;
+              AddNextHop (GetAggregationUplink (pod * half + c / half, c % half), 1, interfaces, gateways);
+              ecmp->AddRoute (Ipv4Address ((10u << 24) | (pod << 16)), podMask, interfaces, gateways);
+            }
+        }
+    }
+  else
+    {
+      for (uint32_t s = 0; s < m_cores.GetN (); ++s)
+        {
+          Ptr<EcmpStaticRouting> ecmp = AddEcmpRouting (m_cores.Get (s));
+          for (uint32_t l = 0; l < m_edges.GetN (); ++l)
+            {
+              std::vector<uint32_t> interfaces;
+              std::vector<Ipv4Address> gateways;
+              AddNextHop (GetEdgeUplink (l, s), 1, interfaces, gateways);
+              ecmp->AddRoute (Ipv4Address ((10u << 24) | ((l >> 8) << 16) | ((l & 0xff) << 8)), edgeMask,
+                              interfaces, gateways);
+            }
+        }
+    }
+}
+
+FabricTopologyHelper::FabricType
+FabricTopologyHelper::GetFabricType (void) const
+{
+  return m_type;
+}
+
+uint32_t
+FabricTopologyHelper::GetK (void) const
+{
+  return m_k;
+}
+
+uint32_t
+FabricTopologyHelper::GetNHosts (void) const
+{
+  return m_hosts.GetN ();
+}
+
+Ptr<Node>
+FabricTopologyHelper::GetHost (uint32_t i) const
+{
+  return m_hosts.Get (i);
+}
+
+Ipv4Address
+FabricTopologyHelper::GetHostAddress (uint32_t i) const
+{
+  return m_hostAddresses[i];
+}
+
+NodeContainer
+FabricTopologyHelper::GetHosts (void) const
+{
+  return m_hosts;
+}
+
+NodeContainer
+FabricTopologyHelper::GetEdgeSwitches (void) const
+{
+  return m_edges;
+}
+
+NodeContainer
+FabricTopologyHelper::GetAggregationSwitches (void) const
+{
+  return m_aggs;
+}
+
+NodeContainer
+FabricTopologyHelper::GetCoreSwitches (void) const
+{
+  return m_cores;
+}
+
+NodeContainer
+FabricTopologyHelper::GetSwitches (void) const
+{
+  return NodeContainer (m_edges, m_aggs, m_cores);
+}
+
+NodeContainer
+FabricTopologyHelper::GetAllNodes (void) const
+{
+  return NodeContainer (m_hosts, m_edges, m_aggs, m_cores);
+}
+
+QueueDiscContainer
+FabricTopologyHelper::GetSwitchQueueDiscs (void) const
+{
+  return m_queueDiscs;
+}
+
+NetDeviceContainer
+FabricTopologyHelper::GetSwitchPorts (void) const
+{
+  return m_switchPorts;
+}
+
+uint32_t
+FabricTopologyHelper::GetHostsPerEdge (void) const
+{
+  return m_hostsPerEdge;
+}
+
+uint32_t
+FabricTopologyHelper::GetHostEdge (uint32_t host) const
+{
+  return host / m_hostsPerEdge;
+}
+
+NetDeviceContainer
+FabricTopologyHelper::GetHostLink (uint32_t host) const
+{
+  return m_hostLinks[host];
+}
+
+NetDeviceContainer
+FabricTopologyHelper::GetEdgeUplink (uint32_t edge, uint32_t j) const
+{
+  return m_edgeUplinkDevs[edge * m_edgeUplinks + j];
+}
+
+NetDeviceContainer
+FabricTopologyHelper::GetAggregationUplink (uint32_t agg, uint32_t j) const
+{
+  return m_aggUplinkDevs[agg * m_aggUplinks + j];
+}
+
+} // namespace ns3
@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FABRIC_TOPOLOGY_HELPER_H
+#define FABRIC_TOPOLOGY_HELPER_H
+
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+#include "ecmp-static-routing.h"
+
+namespace ns3 {
+
+/**
+ * \brief Builds k-ary fat-tree and two tier leaf-spine fabrics.
+ *
+ * The root queue disc given to the Install methods is installed on every
+ * switch egress port, before addressing, so it replaces the default one.
+ * Host ports keep the default queue disc.
+ *
+ * Addressing:
+ *  - host h on edge/leaf switch e of pod p: 10.p.e.(4i)/30, where i is the
+ *    host index on that switch. The switch gets .4i+1 and the host .4i+2, so
+ *    all hosts of an edge switch are covered by 10.p.e.0/24 and all hosts of
+ *    a pod by 10.p.0.0/16. A leaf-spine is a single pod, with the leaf number
+ *    spread over the second and third byte.
+ *  - switch to switch links: consecutive /30 subnets from 172.16.0.0.
+ *
+ * The node ids are: hosts first, then edge (leaf), aggregation and core
+ * (spine) switches.
+ *
+ * For distributed (MPI) runs the nodes are spread over SetSystemCount ranks:
+ * a fat-tree pod (hosts, edge and aggregation switches) or a leaf with its
+ * hosts stays on one rank, and the core/spine switches are dealt round
+ * robin. Only switch to switch links cross ranks, so the lookahead is the
+ * fabric link delay, which must not be zero.
+ */
+class FabricTopologyHelper
+{
+public:
+  enum FabricType
+  {
+    NONE,
+    FAT_TREE,
+    LEAF_SPINE
+  };
+
+  /**
+   * \param hostLink the link between a host and its edge/leaf switch
+   * \param fabricLink the link between two switches
+   */
+  FabricTopologyHelper (const PointToPointHelper &hostLink, const PointToPointHelper &fabricLink);
+
+  /**
+   * Spread the nodes over several MPI ranks. Must be called before Install.
+   * \param systemCount the number of ranks (MpiInterface::GetSize)
+   */
+  void SetSystemCount (uint32_t systemCount);
+
+  /**
+   * Build a k-ary fat-tree: k pods of k/2 edge and k/2 aggregation switches,
+   * (k/2)^2 core switches and k^3/4 hosts.
+   * \param k the switch radix, must be even
+   * \param tch the root queue disc to install on every switch port
+   */
+  void InstallFatTree (uint32_t k, TrafficControlHelper &tch);
+
+  /**
+   * Build a leaf-spine fabric where every leaf connects to every spine.
+   * \param nLeaves number of leaf switches
+   * \param nSpines number of spine switches
+   * \param hostsPerLeaf number of hosts under every leaf, at most 64
+   * \param tch the root queue disc to install on every switch port
+   */
+  void InstallLeafSpine (uint32_t nLeaves, uint32_t nSpines, uint32_t hostsPerLeaf,
+                         TrafficControlHelper &tch);
+
+  /**
+   * Install static routes computed from the fabric structure, in
+   * O(nodes x prefixes) and without any shortest path computation:
+   *  - hosts: default route to their edge/leaf switch;
+   *  - edge/leaf: default route over all uplinks (ECMP);
+   *  - aggregation: one /24 per edge switch of the pod, default over all uplinks;
+   *  - core: one /16 per pod; spine: one /24 per leaf.
+   * The connected networks stay with Ipv4StaticRouting. Multipath uses
+   * EcmpStaticRouting, which hashes the 5-tuple so a flow stays on one path.
+   * Call after InstallFatTree or InstallLeafSpine, instead of
+   * Ipv4GlobalRoutingHelper::PopulateRoutingTables.
+   */
+  void InstallEcmpRoutes (void);
+
+  FabricType GetFabricType (void) const;
+  /// \return k for a fat-tree, 0 for a leaf-spine
+  uint32_t GetK (void) const;
+
+  uint32_t GetNHosts (void) const;
+  Ptr<Node> GetHost (uint32_t i) const;
+  Ipv4Address GetHostAddress (uint32_t i) const;
+  NodeContainer GetHosts (void) const;
+  /// \return the edge switches of a fat-tree or the leaves of a leaf-spine
+  NodeContainer GetEdgeSwitches (void) const;
+  /// \return the aggregation switches of a fat-tree, empty for a leaf-spine
+  NodeContainer GetAggregationSwitches (void) const;
+  /// \return the core switches of a fat-tree or the spines of a leaf-spine
+  NodeContainer GetCoreSwitches (void) const;
+  NodeContainer GetSwitches (void) const;
+  NodeContainer GetAllNodes (void) const;
+  /// \return the root queue discs of all switch ports
+  QueueDiscContainer GetSwitchQueueDiscs (void) const;
+  /// \return the switch ports, in the order of GetSwitchQueueDiscs
+  NetDeviceContainer GetSwitchPorts (void) const;
+
+  /// \return the number of hosts under every edge/leaf switch
+  uint32_t GetHostsPerEdge (void) const;
+  /// \return the index of the edge/leaf switch of the host
+  uint32_t GetHostEdge (uint32_t host) const;
+
+  /**
+   * \param host the host index
+   * \return the link of the host, device 0 on the switch and device 1 on the host
+   */
+  NetDeviceContainer GetHostLink (uint32_t host) const;
+  /**
+   * \param edge the edge/leaf switch index
+   * \param j the uplink index: the aggregation switch within the pod for a
+   *        fat-tree, the spine for a leaf-spine
+   * \return the link, device 0 on the edge/leaf switch
+   */
+  NetDeviceContainer GetEdgeUplink (uint32_t edge, uint32_t j) const;
+  /**
+   * \param agg the aggregation switch index (fat-tree only)
+   * \param j the uplink index, core switch agg%(k/2)*(k/2)+j
+   * \return the link, device 0 on the aggregation switch
+   */
+  NetDeviceContainer GetAggregationUplink (uint32_t agg, uint32_t j) const;
+
+private:
+  void Reset (void);
+  NetDeviceContainer InstallHostLink (Ptr<Node> edge, Ptr<Node> host);
+  NetDeviceContainer InstallFabricLink (Ptr<Node> lower, Ptr<Node> upper);
+  void AssignAddresses (uint32_t edgesPerPod);
+  Ptr<EcmpStaticRouting> AddEcmpRouting (Ptr<Node> node);
+  /// add the far end of the link as a next hop, dev is the index of the near end in link
+  static void AddNextHop (const NetDeviceContainer &link, uint32_t dev,
+                          std::vector<uint32_t> &interfaces, std::vector<Ipv4Address> &gateways);
+
+  PointToPointHelper m_hostLink;
+  PointToPointHelper m_fabricLink;
+
+  FabricType m_type;
+  uint32_t m_systemCount;
+  uint32_t m_k;
+  uint32_t m_hostsPerEdge;
+  uint32_t m_edgeUplinks;   //!< uplinks of every edge/leaf switch
+  uint32_t m_aggUplinks;    //!< uplinks of every aggregation switch
+
+  NodeContainer m_hosts;
+  NodeContainer m_edges;
+  NodeContainer m_aggs;
+  NodeContainer m_cores;
+
+  std::vector<NetDeviceContainer> m_hostLinks;        //!< indexed by host
+  std::vector<NetDeviceContainer> m_edgeUplinkDevs;   //!< edge * m_edgeUplinks + j
+  std::vector<NetDeviceContainer> m_aggUplinkDevs;    //!< agg * m_aggUplinks + j
+  std::vector<Ipv4Address> m_hostAddresses;
+  NetDeviceContainer m_switchPorts;
+  QueueDiscContainer m_queueDiscs;
+};
+
+} // namespace ns3
+
+#endif /* FABRIC_TOPOLOGY_HELPER_H */
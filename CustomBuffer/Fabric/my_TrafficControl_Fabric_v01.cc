@@ -0,0 +1,296 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+//
+// Network topology
+//
+//  k-ary fat-tree (topology=fatTree, k^3/4 hosts, k=16 gives 1024 hosts):
+//
+//        C     C     C     C          core
+//       ...   ...   ...   ...
+//     A   A  A   A  A   A  A   A      aggregation  } pod
+//     E   E  E   E  E   E  E   E      edge         }
+//    h h h h ...               h h    hosts
+//
+//  or leaf-spine (topology=leafSpine, nLeaves * hostsPerLeaf hosts):
+//
+//        S     S     S                spines
+//     L     L     L     L     L       leaves, every leaf to every spine
+//    h h   h h   h h   h h   h h      hosts
+//
+// - The DT or FB queue disc is installed on every switch egress port.
+// - Routes are computed from the fabric structure, with hash based ECMP over
+//   the uplinks (routing=global uses Ipv4GlobalRoutingHelper instead).
+// - Every host sends to the host half the fabric away (permutation traffic),
+//   even hosts with short packets, odd hosts with long packets.
+// - With an MPI enabled build (./ns3 configure --enable-mpi) the fabric is
+//   split over the ranks, see FabricTopologyHelper::SetSystemCount, and every
+//   rank only runs the applications and statistics of its own nodes.
+//  Usage (e.g.): ./ns3 run "scratch/CustomBuffer/Fabric/my_TrafficControl_Fabric_v01 --topology=leafSpine"
+//  Distributed: mpirun -np 4 ./build/scratch/CustomBuffer/Fabric/ns3.36-my_TrafficControl_Fabric_v01-default --k=16
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/traffic-control-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "tutorial-app.h"
+#include "custom_onoff-application.h"
+#include "sim-profiler.h"
+#include "fabric-topology-helper.h"
+#include "results-tables.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#endif
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Traffic_Control_Example_Fabric_v01");
+
+int main (int argc, char *argv[])
+{
+  // Set up some default values for the simulation.
+  double simulationTime = 5; //seconds
+  std::string topology = "fatTree"; // "fatTree"/"leafSpine"
+  uint32_t k = 4;
+  uint32_t nLeaves = 4;
+  uint32_t nSpines = 2;
+  uint32_t hostsPerLeaf = 4;
+  std::string queueDiscType = "DT_FifoQueueDisc_v02"; // "DT_FifoQueueDisc_v02"/"FB_FifoQueueDisc_v01"
+  std::string queue_capacity = "100p"; // B, the total space on the buffer [packets]
+  std::string applicationType = "customOnOff"; // "OnOff"/"customApplication"/"customOnOff"
+  std::string hostLinkRate = "10Mbps";
+  std::string fabricLinkRate = "10Mbps";
+  std::string routing = "ecmp"; // "ecmp"/"global"
+  uint64_t miceBytes = 100000;
+  std::string results;
+
+  bool profile = false;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("simulationTime", "The total time for the simulation to run", simulationTime);
+  cmd.AddValue ("topology", "Fabric to build: fatTree, leafSpine", topology);
+  cmd.AddValue ("k", "Fat-tree radix (k^3/4 hosts)", k);
+  cmd.AddValue ("nLeaves", "Number of leaf switches", nLeaves);
+  cmd.AddValue ("nSpines", "Number of spine switches", nSpines);
+  cmd.AddValue ("hostsPerLeaf", "Number of hosts under every leaf", hostsPerLeaf);
+  cmd.AddValue ("queueDiscType", "Switch queue disc: DT_FifoQueueDisc_v02, FB_FifoQueueDisc_v01", queueDiscType);
+  cmd.AddValue ("queueCapacity", "Size of every switch queue disc", queue_capacity);
+  cmd.AddValue ("applicationType", "Application type to use to send data: customApplication, OnOff, customOnOff", applicationType);
+  cmd.AddValue ("hostLinkRate", "Rate of the host links", hostLinkRate);
+  cmd.AddValue ("fabricLinkRate", "Rate of the switch to switch links", fabricLinkRate);
+  cmd.AddValue ("routing", "Routes: ecmp (computed from the fabric structure), global (Ipv4GlobalRoutingHelper)", routing);
+  cmd.AddValue ("miceBytes", "The largest flow [bytes] counted as mice in the results file", miceBytes);
+  cmd.AddValue ("results", "Also write the per flow and switch queue disc statistics to this columnar binary file", results);
+  cmd.AddValue ("profile", "Print the events and packets per wall second and the queue disc hot path time", profile);
+  cmd.Parse (argc, argv);
+
+  uint32_t systemId = 0;
+  uint32_t systemCount = 1;
+#ifdef NS3_MPI
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+  MpiInterface::Enable (&argc, &argv);
+  systemId = MpiInterface::GetSystemId ();
+  systemCount = MpiInterface::GetSize ();
+#endif
+
+  auto setupStart = std::chrono::steady_clock::now ();
+
+  PointToPointHelper hostLink;
+  hostLink.SetDeviceAttribute  ("DataRate", StringValue (hostLinkRate));
+  hostLink.SetChannelAttribute ("Delay", StringValue ("10us"));
+  // minimal value for NetDevice buffer is 1p. we set it in order to observe Traffic Controll effects only.
+  hostLink.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
+
+  PointToPointHelper fabricLink;
+  fabricLink.SetDeviceAttribute  ("DataRate", StringValue (fabricLinkRate));
+  fabricLink.SetChannelAttribute ("Delay", StringValue ("10us"));
+  fabricLink.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
+
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::" + queueDiscType, "MaxSize", StringValue (queue_capacity));
+
+  FabricTopologyHelper fabric (hostLink, fabricLink);
+  fabric.SetSystemCount (systemCount);
+  if (topology.compare ("leafSpine") == 0)
+    {
+      fabric.InstallLeafSpine (nLeaves, nSpines, hostsPerLeaf, tch);
+    }
+  else
+    {
+      fabric.InstallFatTree (k, tch);
+    }
+
+  // and setup ip routing tables to get total ip-level connectivity.
+  if (routing.compare ("global") == 0)
+    {
+      Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+    }
+  else
+    {
+      fabric.InstallEcmpRoutes ();
+    }
+
+  uint16_t servPort = 50000;
+  Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), servPort));
+  PacketSinkHelper sink ("ns3::UdpSocketFactory", sinkLocalAddress);
+  // every rank builds the whole fabric, but only runs the applications of its own nodes
+  NodeContainer localHosts;
+  for (uint32_t i = 0; i < fabric.GetNHosts (); ++i)
+    {
+      if (fabric.GetHost (i)->GetSystemId () == systemId)
+        {
+          localHosts.Add (fabric.GetHost (i));
+        }
+    }
+  ApplicationContainer sinkApps = sink.Install (localHosts);
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (simulationTime + 0.1));
+
+  uint32_t longPayloadSize = 1024;
+  uint32_t shortPayloadSize = 16;
+  uint32_t payloadSize = 1024;
+  uint32_t numOfPackets = 100;  // number of packets to send in one stream for custom application
+
+  uint32_t nHosts = fabric.GetNHosts ();
+  for (uint32_t i = 0; i < nHosts; ++i)
+    {
+      Ptr<Node> sender = fabric.GetHost (i);
+      if (sender->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      InetSocketAddress remote = InetSocketAddress (fabric.GetHostAddress ((i + nHosts / 2) % nHosts), servPort);
+      ApplicationContainer sourceApps;
+      if (applicationType.compare ("OnOff") == 0)
+        {
+          OnOffHelper clientHelper ("ns3::UdpSocketFactory", Address ());
+          clientHelper.SetAttribute ("Remote", AddressValue (remote));
+          clientHelper.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+          clientHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+          clientHelper.SetAttribute ("PacketSize", UintegerValue (i % 2 == 0 ? shortPayloadSize : longPayloadSize));
+          clientHelper.SetAttribute ("DataRate", StringValue ("1Mb/s"));
+          sourceApps = clientHelper.Install (sender);
+        }
+      else if (applicationType.compare ("customOnOff") == 0)
+        {
+          Ptr<Socket> ns3UdpSocket = Socket::CreateSocket (sender, UdpSocketFactory::GetTypeId ());
+          Ptr<CustomOnOffApplication> customOnOffApp = CreateObject<CustomOnOffApplication> ();
+          customOnOffApp->Setup (ns3UdpSocket);
+          customOnOffApp->SetAttribute ("Remote", AddressValue (remote));
+          customOnOffApp->SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.2]"));
+          customOnOffApp->SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.1]"));
+          customOnOffApp->SetAttribute ("PacketSize", UintegerValue (payloadSize));
+          customOnOffApp->SetAttribute ("DataRate", StringValue ("2Mb/s"));
+          sender->AddApplication (customOnOffApp);
+          sourceApps.Add (customOnOffApp);
+        }
+      else if (applicationType.compare ("customApplication") == 0)
+        {
+          Ptr<Socket> ns3UdpSocket = Socket::CreateSocket (sender, UdpSocketFactory::GetTypeId ());
+          Ptr<TutorialApp> customApp = CreateObject<TutorialApp> ();
+          customApp->Setup (ns3UdpSocket, remote, payloadSize, numOfPackets, DataRate ("1Mbps"));
+          sender->AddApplication (customApp);
+          sourceApps.Add (customApp);
+        }
+      sourceApps.Start (Seconds (1.0));
+      sourceApps.Stop (Seconds (simulationTime));
+    }
+
+  double setupSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - setupStart).count ();
+  std::cout << "Rank " << systemId << ": built " << topology << " with " << nHosts << " hosts and "
+            << fabric.GetSwitches ().GetN () << " switches in " << setupSeconds << " s" << std::endl;
+
+  NS_LOG_INFO ("Run Simulation.");
+  FlowMonitorHelper flowmon;
+  Ptr<FlowMonitor> monitor = flowmon.Install (localHosts);
+
+  Simulator::Stop (Seconds (simulationTime + 1));
+  if (profile)
+    {
+      // the summary is printed by Simulator::Destroy
+      SimProfiler::Get ().Enable ();
+    }
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  // with several ranks a flow that leaves the rank is only seen on the sending side
+  std::cout << std::endl << "*** Flow monitor statistics (rank " << systemId << ") ***" << std::endl;
+  uint64_t txPackets = 0;
+  uint64_t txBytes = 0;
+  uint64_t rxPackets = 0;
+  uint64_t rxBytes = 0;
+  for (const auto &flow : stats)
+    {
+      txPackets += flow.second.txPackets;
+      txBytes += flow.second.txBytes;
+      rxPackets += flow.second.rxPackets;
+      rxBytes += flow.second.rxBytes;
+    }
+  std::cout << "  Flows:   " << stats.size () << std::endl;
+  std::cout << "  Tx Packets/Bytes:   " << txPackets << " / " << txBytes << std::endl;
+  std::cout << "  Rx Packets/Bytes:   " << rxPackets << " / " << rxBytes << std::endl;
+
+  std::cout << std::endl << "*** TC Layer statistics (switch ports of rank " << systemId << ") ***" << std::endl;
+  uint64_t dropped = 0;
+  uint64_t droppedHigh = 0;
+  uint64_t droppedLow = 0;
+  QueueDiscContainer qdiscs = fabric.GetSwitchQueueDiscs ();
+  NetDeviceContainer ports = fabric.GetSwitchPorts ();
+  uint32_t nLocalQueueDiscs = 0;
+  ColumnarResults tables;
+  for (uint32_t i = 0; i < qdiscs.GetN (); ++i)
+    {
+      if (ports.Get (i)->GetNode ()->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      nLocalQueueDiscs++;
+      const QueueDisc::Stats &st = qdiscs.Get (i)->GetStats ();
+      if (!results.empty ())
+        {
+          AddQueueDiscRow (tables, i, st);
+        }
+      dropped += st.nTotalDroppedPackets;
+      droppedHigh += st.nTotalDroppedPacketsBeforeEnqueueHighPriority;
+      droppedLow += st.nTotalDroppedPacketsBeforeEnqueueLowPriority;
+    }
+  std::cout << "  Queue discs:   " << nLocalQueueDiscs << std::endl;
+  std::cout << "  Dropped packets:   " << dropped << std::endl;
+  std::cout << "  Dropped High/Low Priority packets before enqueue:   " << droppedHigh << " / " << droppedLow << std::endl;
+
+  // the same statistics in one file per run for the results tool, one per rank with MPI
+  if (!results.empty ())
+    {
+      AddFlowTable (tables, stats, DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ()), miceBytes);
+      tables.Write (systemCount > 1 ? results + "." + std::to_string (systemId) : results);
+    }
+
+  Simulator::Destroy ();
+#ifdef NS3_MPI
+  MpiInterface::Disable ();
+#endif
+  return 0;
+}
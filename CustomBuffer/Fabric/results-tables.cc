@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "results-tables.h"
+
+namespace ns3 {
+
+/// names of the Ipv4FlowProbe::DropReason values, in order
+static const char *FLOW_DROP_REASONS[] = {
+  "NoRoute", "TtlExpire", "BadChecksum", "Queue", "QueueDisc",
+  "InterfaceDown", "RouteError", "FragmentTimeout"
+};
+
+static const uint32_t N_FLOW_DROP_REASONS = sizeof (FLOW_DROP_REASONS) / sizeof (FLOW_DROP_REASONS[0]);
+
+static uint64_t
+GetNs (Time t)
+{
+  return static_cast<uint64_t> (t.GetNanoSeconds ());
+}
+
+void
+AddFlowTable (ColumnarResults &results, const FlowMonitor::FlowStatsContainer &stats,
+              Ptr<Ipv4FlowClassifier> classifier, uint64_t miceBytes)
+{
+  ColumnarTable &table = results.AddTable ("flows");
+  // look the columns up once, not for every flow
+  const char *names[] = {
+    "flowId", "srcAddr", "dstAddr", "srcPort", "dstPort", "protocol", "class",
+    "txPackets", "txBytes", "rxPackets", "rxBytes", "lostPackets", "timesForwarded",
+    "delaySum", "jitterSum", "timeFirstTxPacket", "timeLastRxPacket", "fct"
+  };
+  const uint32_t nNames = sizeof (names) / sizeof (names[0]);
+  uint32_t column[nNames];
+  for (uint32_t i = 0; i < nNames; ++i)
+    {
+      column[i] = table.AddColumn (names[i]);
+    }
+  uint32_t droppedPackets[N_FLOW_DROP_REASONS];
+  uint32_t droppedBytes[N_FLOW_DROP_REASONS];
+  for (uint32_t r = 0; r < N_FLOW_DROP_REASONS; ++r)
+    {
+      droppedPackets[r] = table.AddColumn (std::string ("droppedPackets:") + FLOW_DROP_REASONS[r]);
+      droppedBytes[r] = table.AddColumn (std::string ("droppedBytes:") + FLOW_DROP_REASONS[r]);
+    }
+
+  for (const auto &flow : stats)
+    {
+      const FlowMonitor::FlowStats &st = flow.second;
+      table.AddRow ();
+      uint32_t i = 0;
+      table.Set (column[i++], static_cast<uint64_t> (flow.first));
+      Ipv4FlowClassifier::FiveTuple t = {};
+      if (classifier)
+        {
+          t = classifier->FindFlow (flow.first);
+        }
+      table.Set (column[i++], static_cast<uint64_t> (t.sourceAddress.Get ()));
+      table.Set (column[i++], static_cast<uint64_t> (t.destinationAddress.Get ()));
+      table.Set (column[i++], static_cast<uint64_t> (t.sourcePort));
+      table.Set (column[i++], static_cast<uint64_t> (t.destinationPort));
+      table.Set (column[i++], static_cast<uint64_t> (t.protocol));
+      table.Set (column[i++], static_cast<uint64_t> (st.txBytes <= miceBytes ? 0 : 1));
+      table.Set (column[i++], static_cast<uint64_t> (st.txPackets));
+      table.Set (column[i++], st.txBytes);
+      table.Set (column[i++], static_cast<uint64_t> (st.rxPackets));
+      table.Set (column[i++], st.rxBytes);
+      table.Set (column[i++], static_cast<uint64_t> (st.lostPackets));
+      table.Set (column[i++], static_cast<uint64_t> (st.timesForwarded));
+      table.Set (column[i++], GetNs (st.delaySum));
+      table.Set (column[i++], GetNs (st.jitterSum));
+      table.Set (column[i++], GetNs (st.timeFirstTxPacket));
+      table.Set (column[i++], GetNs (st.timeLastRxPacket));
+      table.Set (column[i++], st.rxPackets > 0 ? GetNs (st.timeLastRxPacket - st.timeFirstTxPacket) : 0);
+      for (uint32_t r = 0; r < N_FLOW_DROP_REASONS && r < st.packetsDropped.size (); ++r)
+        {
+          table.Set (droppedPackets[r], static_cast<uint64_t> (st.packetsDropped[r]));
+          table.Set (droppedBytes[r], st.bytesDropped[r]);
+        }
+    }
+}
+
+template <typename T>
+static void
+SetPerReason (ColumnarTable &table, const std::string &prefix,
+              const std::map<std::string, T, std::less<>> &values)
+{
+  for (const auto &v : values)
+    {
+      table.Set (prefix + v.first, static_cast<uint64_t> (v.second));
+    }
+}
+
+void
+AddQueueDiscRow (ColumnarResults &results, uint32_t id, const QueueDisc::Stats &stats)
+{
+  ColumnarTable &table = results.AddTable ("queueDiscs");
+  table.AddRow ();
+  table.Set ("id", static_cast<uint64_t> (id));
+  table.Set ("nTotalReceivedPackets", static_cast<uint64_t> (stats.nTotalReceivedPackets));
+  table.Set ("nTotalReceivedBytes", stats.nTotalReceivedBytes);
+  table.Set ("nTotalSentPackets", static_cast<uint64_t> (stats.nTotalSentPackets));
+  table.Set ("nTotalSentBytes", stats.nTotalSentBytes);
+  table.Set ("nTotalEnqueuedPackets", static_cast<uint64_t> (stats.nTotalEnqueuedPackets));
+  table.Set ("nTotalEnqueuedBytes", stats.nTotalEnqueuedBytes);
+  table.Set ("nTotalDequeuedPackets", static_cast<uint64_t> (stats.nTotalDequeuedPackets));
+  table.Set ("nTotalDequeuedBytes", stats.nTotalDequeuedBytes);
+  table.Set ("nTotalDroppedPackets", static_cast<uint64_t> (stats.nTotalDroppedPackets));
+  table.Set ("nTotalDroppedBytes", stats.nTotalDroppedBytes);
+  table.Set ("nTotalDroppedPacketsBeforeEnqueue", static_cast<uint64_t> (stats.nTotalDroppedPacketsBeforeEnqueue));
+  table.Set ("nTotalDroppedBytesBeforeEnqueue", stats.nTotalDroppedBytesBeforeEnqueue);
+  table.Set ("nTotalDroppedPacketsBeforeEnqueueHighPriority",
+             static_cast<uint64_t> (stats.nTotalDroppedPacketsBeforeEnqueueHighPriority));
+  table.Set ("nTotalDroppedBytesBeforeEnqueueHighPriority", stats.nTotalDroppedBytesBeforeEnqueueHighPriority);
+  table.Set ("nTotalDroppedPacketsBeforeEnqueueLowPriority",
+             static_cast<uint64_t> (stats.nTotalDroppedPacketsBeforeEnqueueLowPriority));
+  table.Set ("nTotalDroppedBytesBeforeEnqueueLowPriority", stats.nTotalDroppedBytesBeforeEnqueueLowPriority);
+  table.Set ("nTotalDroppedPacketsAfterDequeue", static_cast<uint64_t> (stats.nTotalDroppedPacketsAfterDequeue));
+  table.Set ("nTotalDroppedBytesAfterDequeue", stats.nTotalDroppedBytesAfterDequeue);
+  table.Set ("nTotalRequeuedPackets", static_cast<uint64_t> (stats.nTotalRequeuedPackets));
+  table.Set ("nTotalRequeuedBytes", stats.nTotalRequeuedBytes);
+  table.Set ("nTotalMarkedPackets", static_cast<uint64_t> (stats.nTotalMarkedPackets));
+  table.Set ("nTotalMarkedBytes", static_cast<uint64_t> (stats.nTotalMarkedBytes));
+  SetPerReason (table, "droppedPacketsBeforeEnqueue:", stats.nDroppedPacketsBeforeEnqueue);
+  SetPerReason (table, "droppedBytesBeforeEnqueue:", stats.nDroppedBytesBeforeEnqueue);
+  SetPerReason (table, "droppedPacketsAfterDequeue:", stats.nDroppedPacketsAfterDequeue);
+  SetPerReason (table, "droppedBytesAfterDequeue:", stats.nDroppedBytesAfterDequeue);
+  SetPerReason (table, "markedPackets:", stats.nMarkedPackets);
+  SetPerReason (table, "markedBytes:", stats.nMarkedBytes);
+  for (uint32_t b = 0; b < QueueDisc::Stats::N_SOJOURN_BUCKETS; ++b)
+    {
+      table.Set ("sojournHigh:" + std::to_string (b), static_cast<uint64_t> (stats.sojournHistogramHighPriority[b]));
+      table.Set ("sojournLow:" + std::to_string (b), static_cast<uint64_t> (stats.sojournHistogramLowPriority[b]));
+    }
+}
+
+} // namespace ns3
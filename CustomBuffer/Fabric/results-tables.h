@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RESULTS_TABLES_H
+#define RESULTS_TABLES_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "queue-disc.h"
+#include "../columnar-results.h"
+
+namespace ns3 {
+
+/**
+ * \brief Add the "flows" table, one row per FlowMonitor flow.
+ *
+ * Columns: flowId, srcAddr, dstAddr (IPv4 addresses as integers), srcPort,
+ * dstPort, protocol, class (0 mice, 1 elephants: more than miceBytes sent,
+ * as FlowStatsCollector), txPackets, txBytes, rxPackets, rxBytes,
+ * lostPackets, timesForwarded, delaySum, jitterSum, timeFirstTxPacket,
+ * timeLastRxPacket and fct (last received - first sent, 0 if nothing was
+ * received), all times in ns, then droppedPackets:<reason> and
+ * droppedBytes:<reason> for every Ipv4FlowProbe drop reason.
+ */
+void AddFlowTable (ColumnarResults &results, const FlowMonitor::FlowStatsContainer &stats,
+                   Ptr<Ipv4FlowClassifier> classifier, uint64_t miceBytes);
+
+/**
+ * \brief Add a row to the "queueDiscs" table.
+ *
+ * Columns: id, the totals of QueueDisc::Stats (nTotalReceivedPackets, ...,
+ * with the High/Low Priority drops), the drops before enqueue, after dequeue
+ * and the marks per reason (droppedPacketsBeforeEnqueue:<reason>, ...), and
+ * the buckets of the sojourn time histograms (sojournHigh:<i>, sojournLow:<i>).
+ * \param results the tables
+ * \param id the queue disc, e.g. its index in a QueueDiscContainer
+ * \param stats its statistics, from GetStats
+ */
+void AddQueueDiscRow (ColumnarResults &results, uint32_t id, const QueueDisc::Stats &stats);
+
+} // namespace ns3
+
+#endif /* RESULTS_TABLES_H */
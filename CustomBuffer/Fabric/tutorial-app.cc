@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tutorial-app.h"
+#include "ns3/applications-module.h"
+#include "customTag.h"
+
+using namespace ns3;
+
+TutorialApp::TutorialApp ()
+  : m_socket (0),
+    m_peer (),
+    m_packetSize (0),
+    m_nPackets (0),
+    m_dataRate (0),
+    m_sendEvent (),
+    m_running (false),
+    m_packetsSent (0),
+    m_packetsSentAtStart (0),
+    m_miceThreshold (10)
+{
+}
+
+TutorialApp::~TutorialApp ()
+{
+  m_socket = 0;
+}
+
+/* static */
+TypeId TutorialApp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("TutorialApp")
+    .SetParent<Application> ()
+    .SetGroupName ("Tutorial")
+    .AddConstructor<TutorialApp> ()
+    .AddAttribute ("MiceThreshold",
+                   "The number of packets at the start of the flow "
+                   "that are sent with high priority (mice)",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&TutorialApp::m_miceThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    ;
+  return tid;
+}
+
+void
+TutorialApp::Setup (Ptr<Socket> socket, Address address, uint32_t packetSize, uint32_t nPackets, DataRate dataRate)
+{
+  m_socket = socket;
+  m_peer = address;
+  m_packetSize = packetSize;
+  m_nPackets = nPackets;
+  m_dataRate = dataRate;
+}
+
+uint32_t
+TutorialApp::GetPacketsSent (void) const
+{
+  return m_packetsSent;
+}
+
+void
+TutorialApp::SetPacketsSentAtStart (uint32_t packetsSent)
+{
+  m_packetsSentAtStart = packetsSent;
+}
+
+void
+TutorialApp::StartApplication (void)
+{
+  m_running = true;
+  m_packetsSent = m_packetsSentAtStart;
+  m_socket->Bind ();
+  m_socket->Connect (m_peer);
+  // nothing left to send when the checkpoint was taken after the last packet
+  if (m_packetsSentAtStart == 0 || m_packetsSent < m_nPackets)
+    {
+      SendPacket ();
+    }
+}
+
+void
+TutorialApp::StopApplication (void)
+{
+  m_running = false;
+
+  if (m_sendEvent.IsRunning ())
+    {
+      Simulator::Cancel (m_sendEvent);
+    }
+
+  if (m_socket)
+    {
+      m_socket->Close ();
+    }
+}
+
+
+void
+TutorialApp::SendPacket (void)
+{
+  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  // create a tag.
+  MyTag flowPrioTag;
+  // set Tag value to depend on the number of previously sent packets
+  // if m_packetsSent < m_miceThreshold: TagValue->0x0 (High Priority)
+  // if m_packetsSent >= m_miceThreshold: TagValue->0x1 (Low Priority)
+  
+  // m_miceThreshold [packets], max number of packets per flow to be considered mouse flow
+  if (m_packetsSent < m_miceThreshold)
+  {
+    flowPrioTag.SetSimpleValue (0x0);
+  }
+  else 
+    flowPrioTag.SetSimpleValue (0x1);
+
+  // store the tag in a packet.
+  packet->AddPacketTag (flowPrioTag);
+  m_socket->Send (packet);
+
+  if (++m_packetsSent < m_nPackets)
+    {
+      ScheduleTx ();
+    }
+}
+
+void
+TutorialApp::ScheduleTx (void)
+{
+  if (m_running)
+    {
+      Time tNext (Seconds (m_packetSize * 8 / static_cast<double> (m_dataRate.GetBitRate ())));
+      m_sendEvent = Simulator::Schedule (tNext, &TutorialApp::SendPacket, this);
+    }
+}
@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/abort.h"
+#include "fluid-model.h"
+
+namespace ns3 {
+
+double
+FluidModelResult::GetDropFraction (uint32_t c) const
+{
+  return offered[c] > 0 ? dropped[c] / offered[c] : 0;
+}
+
+FluidQueueModel::FluidQueueModel (const FluidModelConfig &config)
+  : m_config (config)
+{
+  NS_ABORT_MSG_IF (config.maxSize <= 0 || config.drainRate <= 0, "MaxSize and the drain rate must be positive");
+  NS_ABORT_MSG_IF (config.step <= 0 || config.duration <= 0, "The step and the duration must be positive");
+  NS_ABORT_MSG_IF (config.alphaHigh < 0 || config.alphaLow < 0 || config.gamma < 0, "Negative alpha or gamma");
+  NS_ABORT_MSG_IF (config.numClasses == 0 || config.numClasses > 2, "NumClasses must be 1 or 2, as in the queue disc");
+  m_alpha[0] = Quantize (config.alphaHigh);
+  m_alpha[1] = Quantize (config.alphaLow);
+  m_gamma = Quantize (config.gamma);
+}
+
+double
+FluidQueueModel::Quantize (double alpha)
+{
+  return std::floor (alpha * 65536 + 0.5) / 65536;
+}
+
+FluidModelResult
+FluidQueueModel::Run (void) const
+{
+  const uint32_t N = FluidModelConfig::N_CLASSES;
+  const FluidModelConfig &cfg = m_config;
+  double B = cfg.maxSize;
+  double dt = cfg.step;
+  uint64_t nSteps = static_cast<uint64_t> (std::ceil (cfg.duration / dt));
+  // on/off phase in steps, to avoid a fmod per step
+  uint64_t onSteps = static_cast<uint64_t> (std::llround (cfg.onTime / dt));
+  uint64_t periodSteps = onSteps + static_cast<uint64_t> (std::llround (cfg.offTime / dt));
+  uint64_t phase = 0;
+
+  FluidModelResult r = {};
+  double q[N] = {0, 0};
+  double departed = 0;
+  double factor = cfg.fb ? m_gamma : 1;
+
+  for (uint64_t step = 0; step < nSteps; ++step)
+    {
+      // FIFO departures, shared in proportion to the occupancy of the classes
+      double Q = q[0] + q[1];
+      double out = std::min (Q, cfg.drainRate * dt);
+      if (Q > 0)
+        {
+          for (uint32_t c = 0; c < N; ++c)
+            {
+              q[c] -= out * q[c] / Q;
+            }
+          Q -= out;
+        }
+      departed += out;
+
+      // FB factor from the congestion at the start of the step
+      if (cfg.fb)
+        {
+          uint32_t nCongested = 0;
+          for (uint32_t c = 0; c < N; ++c)
+            {
+              double threshold = m_alpha[c] * factor * (B - Q);
+              nCongested += (q[c] > 0 && q[c] >= threshold) ? 1 : 0;
+            }
+          factor = nCongested < cfg.numClasses ? m_gamma : 0;
+        }
+
+      // arrivals, the class with the lower threshold is limited first
+      bool on = cfg.offTime <= 0 || phase < onSteps;
+      phase = phase + 1 < periodSteps ? phase + 1 : 0;
+      uint32_t order[N] = {0, 1};
+      if (m_alpha[1] < m_alpha[0])
+        {
+          std::swap (order[0], order[1]);
+        }
+      for (uint32_t i = 0; i < N; ++i)
+        {
+          uint32_t c = order[i];
+          double offered = on ? cfg.rate[c] * dt : 0;
+          double af = m_alpha[c] * factor;
+          // largest x with Q + x <= alpha_c * f * (B - Q - x), and Q + x <= B
+          double room = std::max (0.0, (af * (B - Q) - Q) / (1 + af));
+          double x = std::min (offered, std::min (room, B - Q));
+          q[c] += x;
+          Q += x;
+          r.offered[c] += offered;
+          r.admitted[c] += x;
+          r.dropped[c] += offered - x;
+        }
+
+      for (uint32_t c = 0; c < N; ++c)
+        {
+          r.meanOccupancy[c] += q[c] * dt;
+        }
+      r.maxOccupancy = std::max (r.maxOccupancy, Q);
+    }
+
+  double Q = q[0] + q[1];
+  for (uint32_t c = 0; c < N; ++c)
+    {
+      r.occupancy[c] = q[c];
+      r.threshold[c] = m_alpha[c] * factor * (B - Q);
+      r.meanOccupancy[c] /= nSteps * dt;
+    }
+  r.utilization = departed / (cfg.drainRate * nSteps * dt);
+  return r;
+}
+
+} // namespace ns3
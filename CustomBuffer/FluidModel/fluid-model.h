@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_MODEL_H
+#define FLUID_MODEL_H
+
+#include <cstdint>
+
+namespace ns3 {
+
+/**
+ * \brief Parameters of the fluid model, named after the queue disc attributes.
+ *
+ * Class 0 is high priority and class 1 low priority, as the MyTag values.
+ * Queue sizes and rates are in packets, like the "100p" queue capacities of
+ * the scenarios.
+ */
+struct FluidModelConfig
+{
+  static const uint32_t N_CLASSES = 2;
+
+  bool fb {true};              //!< FB thresholds (FB_FifoQueueDisc_v01), DT otherwise
+  double alphaHigh {2.0};      //!< AlphaHigh
+  double alphaLow {1.0};       //!< AlphaLow
+  double gamma {1.0};          //!< Gamma, FB only
+  uint32_t numClasses {2};     //!< NumClasses, FB only
+  double maxSize {100};        //!< MaxSize, B [packets]
+  double drainRate {1000};     //!< C, the dequeue rate of the port [packets/s]
+  double rate[N_CLASSES] {600, 600};  //!< arrival rate of every class while on [packets/s]
+  double onTime {0.2};         //!< [s]
+  double offTime {0.1};        //!< [s], 0 for always on
+  double duration {2};         //!< [s], the sending time of the incast senders
+  double step {1e-4};          //!< integration step [s]
+};
+
+/// \brief What the fluid model measured over a run
+struct FluidModelResult
+{
+  double occupancy[FluidModelConfig::N_CLASSES];      //!< at the end [packets]
+  double threshold[FluidModelConfig::N_CLASSES];      //!< at the end [packets]
+  double meanOccupancy[FluidModelConfig::N_CLASSES];  //!< time average [packets]
+  double offered[FluidModelConfig::N_CLASSES];        //!< [packets]
+  double admitted[FluidModelConfig::N_CLASSES];       //!< [packets]
+  double dropped[FluidModelConfig::N_CLASSES];        //!< [packets]
+  double maxOccupancy;                                //!< of the whole queue [packets]
+  double utilization;                                 //!< departed / (C * duration)
+
+  /// \return the share of the offered packets of the class that were dropped
+  double GetDropFraction (uint32_t c) const;
+};
+
+/**
+ * \brief Fluid model of the shared buffer with DT or FB thresholds.
+ *
+ * The queue is a FIFO drained at C packets/s, shared by the classes in
+ * proportion to their occupancy q_c. A class is admitted while the total
+ * occupancy Q is below its threshold, as in DoEnqueue:
+ *
+ *   T_c(t) = alpha_c * f(t) * (B - Q(t))
+ *
+ * with f = 1 for DT, and for FB f = gamma while fewer than NumClasses classes
+ * are congested (q_c >= T_c), 0 otherwise, the integer division of
+ * GetThresholdFactor. The alphas and gamma are rounded to the same fixed
+ * point as QueueDisc::AlphaToFixedPoint.
+ *
+ * The equations are integrated with a fixed step. At a threshold, a class is
+ * admitted just enough for Q to stay at T_c and the rest is dropped, the
+ * fluid limit of the packet level admission; the classes with the lower
+ * thresholds are served first. The arrivals follow the on/off pattern of
+ * CustomOnOffApplication, all classes on at the same time.
+ *
+ * No packets, no events, no ns-3 objects: a 2 s run takes about a millisecond, so
+ * large parameter spaces can be scanned before validating the interesting
+ * points with the queue discs.
+ */
+class FluidQueueModel
+{
+public:
+  explicit FluidQueueModel (const FluidModelConfig &config);
+
+  /// integrate from an empty queue over config.duration
+  FluidModelResult Run (void) const;
+
+  /// round like QueueDisc::AlphaToFixedPoint, with ALPHA_SHIFT = 16
+  static double Quantize (double alpha);
+
+private:
+  FluidModelConfig m_config;
+  double m_alpha[FluidModelConfig::N_CLASSES];   //!< quantized alphas
+  double m_gamma;                                //!< quantized gamma
+};
+
+} // namespace ns3
+
+#endif /* FLUID_MODEL_H */
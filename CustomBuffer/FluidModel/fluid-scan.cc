@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Parameter scan of the DT/FB thresholds with the fluid model (fluid-model.h).
+//
+// The grid has the syntax of the sweep runner, name=v1,v2;name2=v3,..., with
+// the queue disc attribute names AlphaHigh, AlphaLow, Gamma, NumClasses and
+// MaxSize [packets], and the traffic of the model: DrainRate, RateHigh,
+// RateLow [packets/s], OnTime, OffTime [s]. Every point of the grid is
+// integrated, nThreads at a time, and written as one row of the results
+// table. Its last column, queueDiscArguments, has the command line arguments
+// that set the same queue disc and capacity in the packet level scenarios.
+// The traffic is not translated: the scenarios have no DrainRate, RateHigh,
+// RateLow, OnTime or OffTime arguments, so the link rates and the senders
+// have to be matched to the model by hand. A scan is e.g.
+//
+//  ./ns3 run "CustomBuffer/FluidModel/fluid-scan --queueDisc=FB
+//     --grid=AlphaHigh=0.5,1,2,4,8;AlphaLow=0.25,0.5,1,2;Gamma=0.5,1;RateLow=200,600,1000"
+//
+// then the interesting rows are validated with the incast scenario and the
+// sweep runner.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ns3/core-module.h"
+#include "fluid-model.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FluidScan");
+
+struct ScanParam
+{
+  std::string name;
+  std::vector<std::string> values;
+};
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::string item;
+  std::istringstream is (s);
+  while (std::getline (is, item, sep))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+// "name=v1,v2;name2=v3" -> {name: [v1, v2]}, {name2: [v3]}
+static std::vector<ScanParam>
+ParseGrid (const std::string &grid)
+{
+  std::vector<ScanParam> params;
+  for (const std::string &entry : Split (grid, ';'))
+    {
+      std::size_t eq = entry.find ('=');
+      NS_ABORT_MSG_IF (eq == std::string::npos || eq == 0, "Bad grid entry " << entry << ", expected name=v1,v2,...");
+      ScanParam p;
+      p.name = entry.substr (0, eq);
+      p.values = Split (entry.substr (eq + 1), ',');
+      NS_ABORT_MSG_IF (p.values.empty (), "No values for " << p.name);
+      params.push_back (p);
+    }
+  return params;
+}
+
+static void
+SetParam (FluidModelConfig &config, const std::string &name, double value)
+{
+  if (name == "AlphaHigh")
+    {
+      config.alphaHigh = value;
+    }
+  else if (name == "AlphaLow")
+    {
+      config.alphaLow = value;
+    }
+  else if (name == "Gamma")
+    {
+      config.gamma = value;
+    }
+  else if (name == "NumClasses")
+    {
+      config.numClasses = static_cast<uint32_t> (value);
+    }
+  else if (name == "MaxSize")
+    {
+      config.maxSize = value;
+    }
+  else if (name == "DrainRate")
+    {
+      config.drainRate = value;
+    }
+  else if (name == "RateHigh")
+    {
+      config.rate[0] = value;
+    }
+  else if (name == "RateLow")
+    {
+      config.rate[1] = value;
+    }
+  else if (name == "OnTime")
+    {
+      config.onTime = value;
+    }
+  else if (name == "OffTime")
+    {
+      config.offTime = value;
+    }
+  else
+    {
+      NS_ABORT_MSG ("Unknown fluid model parameter " << name);
+    }
+}
+
+// the arguments that set the queue disc of this point in the packet level
+// scenarios, without the traffic (see the top of the file)
+static std::string
+GetAttributes (const FluidModelConfig &config)
+{
+  std::ostringstream os;
+  std::string prefix = config.fb ? "--ns3::FB_FifoQueueDisc_v01::" : "--ns3::DT_FifoQueueDisc_v02::";
+  os << prefix << "AlphaHigh=" << config.alphaHigh << " " << prefix << "AlphaLow=" << config.alphaLow;
+  if (config.fb)
+    {
+      os << " " << prefix << "Gamma=" << config.gamma << " " << prefix << "NumClasses=" << config.numClasses;
+    }
+  os << " --queueCapacity=" << config.maxSize << "p";
+  return os.str ();
+}
+
+int main (int argc, char *argv[])
+{
+  std::string queueDisc = "FB";
+  std::string grid;
+  double duration = 2;
+  double step = 1e-4;
+  uint32_t nThreads = std::thread::hardware_concurrency ();
+  std::string results = "./CustomBuffer/FluidModel/fluid-scan.tsv";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("queueDisc", "Thresholds to model: FB, DT", queueDisc);
+  cmd.AddValue ("grid", "The parameter grid: name=v1,v2;name2=v3,...", grid);
+  cmd.AddValue ("duration", "Time integrated per point [s]", duration);
+  cmd.AddValue ("step", "Integration step [s]", step);
+  cmd.AddValue ("nThreads", "Number of points integrated at the same time, default one per core", nThreads);
+  cmd.AddValue ("results", "The results table", results);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (queueDisc != "FB" && queueDisc != "DT", "Unknown queueDisc " << queueDisc);
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+
+  std::vector<ScanParam> params = ParseGrid (grid);
+  uint32_t nPoints = 1;
+  for (const ScanParam &p : params)
+    {
+      nPoints *= p.values.size ();
+    }
+
+  // the cartesian product of the grid, the last parameter changes fastest
+  std::vector<FluidModelConfig> configs (nPoints);
+  std::vector<std::vector<std::string> > values (nPoints, std::vector<std::string> (params.size ()));
+  for (uint32_t point = 0; point < nPoints; ++point)
+    {
+      configs[point].fb = queueDisc == "FB";
+      configs[point].duration = duration;
+      configs[point].step = step;
+      uint32_t rest = point;
+      for (uint32_t i = params.size (); i-- > 0;)
+        {
+          values[point][i] = params[i].values[rest % params[i].values.size ()];
+          rest /= params[i].values.size ();
+          SetParam (configs[point], params[i].name, std::stod (values[point][i]));
+        }
+    }
+
+  // every thread takes the next point until there is none left
+  std::vector<FluidModelResult> out (nPoints);
+  std::atomic<uint32_t> next (0);
+  auto start = std::chrono::steady_clock::now ();
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < std::min (nThreads, nPoints); ++t)
+    {
+      threads.emplace_back ([&] () {
+        for (uint32_t point = next++; point < nPoints; point = next++)
+          {
+            out[point] = FluidQueueModel (configs[point]).Run ();
+          }
+      });
+    }
+  for (std::thread &t : threads)
+    {
+      t.join ();
+    }
+  double wall = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  std::ofstream tsv (results);
+  NS_ABORT_MSG_IF (!tsv, "Can not open " << results);
+  tsv << "point";
+  for (const ScanParam &p : params)
+    {
+      tsv << "\t" << p.name;
+    }
+  tsv << "\tdropHigh\tdropLow\tmeanOccupancyHigh\tmeanOccupancyLow\toccupancyHigh\toccupancyLow"
+      << "\tthresholdHigh\tthresholdLow\tmaxOccupancy\tutilization\tqueueDiscArguments\n";
+  for (uint32_t point = 0; point < nPoints; ++point)
+    {
+      const FluidModelResult &r = out[point];
+      tsv << point;
+      for (const std::string &v : values[point])
+        {
+          tsv << "\t" << v;
+        }
+      tsv << "\t" << r.GetDropFraction (0) << "\t" << r.GetDropFraction (1)
+          << "\t" << r.meanOccupancy[0] << "\t" << r.meanOccupancy[1]
+          << "\t" << r.occupancy[0] << "\t" << r.occupancy[1]
+          << "\t" << r.threshold[0] << "\t" << r.threshold[1]
+          << "\t" << r.maxOccupancy << "\t" << r.utilization
+          << "\t" << GetAttributes (configs[point]) << "\n";
+    }
+  tsv.close ();
+
+  std::cout << std::endl << "*** Fluid model scan ***" << std::endl;
+  std::cout << "  Points:   " << nPoints << std::endl;
+  std::cout << "  Wall time:   " << wall << " s" << std::endl;
+  std::cout << "  Points per wall second:   " << (wall > 0 ? nPoints / wall : 0) << std::endl;
+  std::cout << "  Results:   " << results << std::endl;
+  return 0;
+}
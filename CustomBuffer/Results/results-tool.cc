@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Loads the columnar results files of many runs (columnar-results.h), e.g.
+// the ones of a sweep run with --columnar=1, and writes one table of them as
+// tab separated text:
+//  - rows:    every row of every file, with the file in the first column;
+//  - sum:     one row per file (and groupBy value), the columns summed;
+//  - summary: one row per column (and groupBy value), the count, sum, mean,
+//             min and max over the rows of all files.
+// For example the drops and the FCT of the mice over a sweep:
+//
+//  ./ns3 run "CustomBuffer/Results/results-tool
+//     --files=CustomBuffer/Sweep/runs/run-*.cols --table=flows --mode=sum --groupBy=class
+//     --columns=txBytes,rxBytes,droppedPackets:QueueDisc,fct"
+//
+// The files are read nThreads at a time.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <glob.h>
+
+#include "ns3/core-module.h"
+#include "../columnar-results.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ResultsTool");
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::string item;
+  std::istringstream is (s);
+  while (std::getline (is, item, sep))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+// the files matching any of the space separated patterns, sorted
+static std::vector<std::string>
+GlobFiles (const std::string &patterns)
+{
+  std::vector<std::string> files;
+  for (const std::string &pattern : Split (patterns, ' '))
+    {
+      glob_t g;
+      if (glob (pattern.c_str (), 0, nullptr, &g) == 0)
+        {
+          files.insert (files.end (), g.gl_pathv, g.gl_pathv + g.gl_pathc);
+        }
+      globfree (&g);
+    }
+  std::sort (files.begin (), files.end ());
+  return files;
+}
+
+struct ColumnSummary
+{
+  uint64_t count {0};
+  double sum {0};
+  double min {std::numeric_limits<double>::max ()};
+  double max {std::numeric_limits<double>::lowest ()};
+};
+
+int main (int argc, char *argv[])
+{
+  std::string files;
+  std::string table = "flows";
+  std::string columns;
+  std::string mode = "rows";
+  std::string groupBy;
+  std::string out;
+  uint32_t nThreads = std::thread::hardware_concurrency ();
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("files", "The results files, space separated glob patterns", files);
+  cmd.AddValue ("table", "The table to read: flows, queueDiscs", table);
+  cmd.AddValue ("columns", "Comma separated columns to write, default all", columns);
+  cmd.AddValue ("mode", "rows, sum (per file), summary (per column)", mode);
+  cmd.AddValue ("groupBy", "Column whose values split the sums and summaries, e.g. class", groupBy);
+  cmd.AddValue ("out", "The output file, default stdout", out);
+  cmd.AddValue ("nThreads", "Number of files read at the same time, default one per core", nThreads);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (mode != "rows" && mode != "sum" && mode != "summary", "Unknown mode " << mode);
+  std::vector<std::string> fileNames = GlobFiles (files);
+  NS_ABORT_MSG_IF (fileNames.empty (), "No file matches " << files);
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+
+  // every thread takes the next file until there is none left
+  std::vector<ColumnarResults> loaded (fileNames.size ());
+  std::vector<char> ok (fileNames.size (), 0);
+  std::atomic<uint32_t> next (0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < std::min<std::size_t> (nThreads, fileNames.size ()); ++t)
+    {
+      threads.emplace_back ([&] () {
+        for (uint32_t f = next++; f < fileNames.size (); f = next++)
+          {
+            ok[f] = loaded[f].Read (fileNames[f]);
+          }
+      });
+    }
+  for (std::thread &t : threads)
+    {
+      t.join ();
+    }
+
+  // the columns of the output, by default all columns in the order they are first seen
+  std::vector<std::string> names = Split (columns, ',');
+  bool allColumns = names.empty ();
+  uint32_t nRead = 0;
+  for (uint32_t f = 0; f < fileNames.size (); ++f)
+    {
+      if (!ok[f])
+        {
+          std::cerr << "Skipping " << fileNames[f] << ": not a results file" << std::endl;
+          continue;
+        }
+      nRead++;
+      const ColumnarTable *t = loaded[f].GetTable (table);
+      for (uint32_t c = 0; allColumns && t && c < t->GetNColumns (); ++c)
+        {
+          if (std::find (names.begin (), names.end (), t->GetColumnName (c)) == names.end ())
+            {
+              names.push_back (t->GetColumnName (c));
+            }
+        }
+    }
+
+  std::ofstream file;
+  if (!out.empty ())
+    {
+      file.open (out);
+      NS_ABORT_MSG_IF (!file, "Can not open " << out);
+    }
+  std::ostream &os = out.empty () ? std::cout : file;
+  // sums of byte and packet counters need all their digits, not the default 6
+  os.precision (std::numeric_limits<double>::max_digits10);
+
+  // groupBy value -> per column summaries, of all files for the summary mode
+  std::map<double, std::vector<ColumnSummary> > total;
+  if (mode == "rows" || mode == "sum")
+    {
+      os << "file";
+      if (mode == "sum" && !groupBy.empty ())
+        {
+          os << "\t" << groupBy;
+        }
+      for (const std::string &n : names)
+        {
+          os << "\t" << n;
+        }
+      os << "\n";
+    }
+  else
+    {
+      os << (groupBy.empty () ? "" : groupBy + "\t") << "column\tcount\tsum\tmean\tmin\tmax\n";
+    }
+
+  for (uint32_t f = 0; f < fileNames.size (); ++f)
+    {
+      const ColumnarTable *t = ok[f] ? loaded[f].GetTable (table) : 0;
+      if (!t)
+        {
+          continue;
+        }
+      std::vector<int32_t> index (names.size ());
+      for (uint32_t i = 0; i < names.size (); ++i)
+        {
+          index[i] = t->FindColumn (names[i]);
+        }
+      int32_t group = groupBy.empty () ? -1 : t->FindColumn (groupBy);
+      NS_ABORT_MSG_IF (!groupBy.empty () && group < 0, "No column " << groupBy << " in " << fileNames[f]);
+
+      std::map<double, std::vector<ColumnSummary> > perFile;
+      for (uint64_t row = 0; row < t->GetNRows (); ++row)
+        {
+          if (mode == "rows")
+            {
+              os << fileNames[f];
+              for (int32_t c : index)
+                {
+                  os << "\t";
+                  if (c >= 0)
+                    {
+                      if (t->GetColumnType (c) == ColumnarTable::UINT64)
+                        {
+                          os << t->GetUint (c, row);
+                        }
+                      else
+                        {
+                          os << t->GetDouble (c, row);
+                        }
+                    }
+                }
+              os << "\n";
+              continue;
+            }
+          double key = group < 0 ? 0 : t->GetDouble (group, row);
+          std::vector<ColumnSummary> &s = (mode == "sum" ? perFile : total)[key];
+          s.resize (names.size ());
+          for (uint32_t i = 0; i < names.size (); ++i)
+            {
+              if (index[i] < 0)
+                {
+                  continue;
+                }
+              double v = t->GetDouble (index[i], row);
+              s[i].count++;
+              s[i].sum += v;
+              s[i].min = std::min (s[i].min, v);
+              s[i].max = std::max (s[i].max, v);
+            }
+        }
+      for (const auto &g : perFile)
+        {
+          os << fileNames[f];
+          if (!groupBy.empty ())
+            {
+              os << "\t" << g.first;
+            }
+          for (const ColumnSummary &s : g.second)
+            {
+              os << "\t" << s.sum;
+            }
+          os << "\n";
+        }
+    }
+
+  for (const auto &g : total)
+    {
+      for (uint32_t i = 0; i < names.size (); ++i)
+        {
+          const ColumnSummary &s = g.second[i];
+          if (!groupBy.empty ())
+            {
+              os << g.first << "\t";
+            }
+          os << names[i] << "\t" << s.count << "\t" << s.sum << "\t" << (s.count ? s.sum / s.count : 0)
+             << "\t" << (s.count ? s.min : 0) << "\t" << (s.count ? s.max : 0) << "\n";
+        }
+    }
+  os.flush ();
+
+  std::cerr << "Read " << nRead << " of " << fileNames.size () << " files" << std::endl;
+  return 0;
+}
@@ -0,0 +1,428 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// End to end benchmark of the simulation scenarios.
+//
+// Runs a fixed set of cases, the incast (FB_FIFO), line (DT_FIFO) and BBR
+// scenarios at a few scales, one process at a time so they do not compete
+// for the cores, each repeats times. Per case it records:
+//  - wallTime: median wall time of the process [s]
+//  - userTime, sysTime: median CPU times [s]
+//  - maxRssKb: largest peak resident set of the repeats, from wait4
+//  - events, simTime: events processed and simulated seconds, as printed by
+//    the scenario ("Events:" and "Simulated time:", see sim-profiler.h and
+//    my_tcp-bbr-example.cc)
+//  - simSecondsPerWallSecond, eventsPerWallSecond
+// into a tab separated results file, one row per case.
+//
+// If the baseline file exists the results are compared with it: a case
+// regresses when its wall time or peak RSS is more than tolerance above the
+// baseline, and the program then exits with 1. A case whose number of events
+// changed is reported too, since its timings are no longer comparable. The
+// baseline is a results file of an earlier run, stored with --saveBaseline.
+//
+//  ./ns3 run "CustomBuffer/ScenarioBench/scenario-bench --cases=incast,bbr --repeats=5"
+//  ./ns3 run "CustomBuffer/ScenarioBench/scenario-bench --saveBaseline=true"
+//
+// The programs are looked up in the build directory of ns-3.36, they can be
+// changed with --incast, --line and --bbr.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("ScenarioBench");
+
+struct BenchCase
+{
+  std::string name;
+  std::string program;
+  std::vector<std::string> args;
+};
+
+struct BenchRun
+{
+  int status {-1};
+  double wallTime {0};    //!< [s]
+  double userTime {0};    //!< [s]
+  double sysTime {0};     //!< [s]
+  long maxRssKb {0};
+  double events {-1};
+  double simTime {-1};    //!< [s]
+};
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::string item;
+  std::istringstream is (s);
+  while (std::getline (is, item, sep))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+static double
+Median (std::vector<double> v)
+{
+  if (v.empty ())
+    {
+      return 0;
+    }
+  std::sort (v.begin (), v.end ());
+  uint32_t n = v.size ();
+  return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// the number at the start of the value of the first "key: value" line with
+// this key after a "***" header, -1 if there is none
+static double
+ReadSummaryValue (const std::string &logFile, const std::string &key)
+{
+  std::ifstream log (logFile);
+  std::string line;
+  bool inSummary = false;
+  while (std::getline (log, line))
+    {
+      if (line.find ("***") != std::string::npos)
+        {
+          inSummary = true;
+          continue;
+        }
+      std::size_t colon = line.find (':');
+      if (!inSummary || colon == std::string::npos)
+        {
+          continue;
+        }
+      std::size_t begin = line.find_first_not_of (" \t");
+      if (line.compare (begin, colon - begin, key) == 0)
+        {
+          return std::strtod (line.c_str () + colon + 1, nullptr);
+        }
+    }
+  return -1;
+}
+
+static BenchRun
+RunCase (const BenchCase &c, const std::string &logFile, const std::string &errFile)
+{
+  std::vector<std::string> args;
+  args.push_back (c.program);
+  args.insert (args.end (), c.args.begin (), c.args.end ());
+  std::vector<char *> argv;
+  for (std::string &a : args)
+    {
+      argv.push_back (&a[0]);
+    }
+  argv.push_back (nullptr);
+
+  std::cout.flush ();
+  auto start = std::chrono::steady_clock::now ();
+  pid_t pid = fork ();
+  if (pid == 0)
+    {
+      int out = open (logFile.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      int err = open (errFile.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (out < 0 || err < 0 || dup2 (out, STDOUT_FILENO) < 0 || dup2 (err, STDERR_FILENO) < 0)
+        {
+          _exit (126);
+        }
+      close (out);
+      close (err);
+      execv (argv[0], argv.data ());
+      _exit (127);
+    }
+  NS_ABORT_MSG_IF (pid < 0, "fork failed");
+
+  // wait4 gives the resource usage of this child alone, unlike getrusage
+  // (RUSAGE_CHILDREN) which accumulates over all the waited children
+  int status;
+  struct rusage usage;
+  while (wait4 (pid, &status, 0, &usage) < 0)
+    {
+      NS_ABORT_MSG_IF (errno != EINTR, "wait4 failed");
+    }
+
+  BenchRun run;
+  run.wallTime = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  run.status = WIFEXITED (status) ? WEXITSTATUS (status) : 128 + WTERMSIG (status);
+  run.userTime = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6;
+  run.sysTime = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+  run.maxRssKb = usage.ru_maxrss;   // kilobytes on Linux
+  run.events = ReadSummaryValue (logFile, "Events");
+  run.simTime = ReadSummaryValue (logFile, "Simulated time");
+  return run;
+}
+
+// results/baseline file: a header line, then one row per case
+static std::map<std::string, std::map<std::string, std::string>>
+ReadResults (const std::string &fileName)
+{
+  std::map<std::string, std::map<std::string, std::string>> rows;
+  std::ifstream in (fileName);
+  std::string line;
+  if (!std::getline (in, line))
+    {
+      return rows;
+    }
+  std::vector<std::string> columns;
+  std::istringstream header (line);
+  for (std::string c; std::getline (header, c, '\t');)
+    {
+      columns.push_back (c);
+    }
+  while (std::getline (in, line))
+    {
+      std::istringstream is (line);
+      std::map<std::string, std::string> row;
+      std::string value;
+      for (uint32_t i = 0; i < columns.size () && std::getline (is, value, '\t'); ++i)
+        {
+          row[columns[i]] = value;
+        }
+      if (!row["case"].empty ())
+        {
+          rows[row["case"]] = row;
+        }
+    }
+  return rows;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string buildDir = "./build/scratch";
+  std::string incast = "";
+  std::string line = "";
+  std::string bbr = "";
+  std::string cases = "";
+  uint32_t repeats = 3;
+  std::string outDir = "./CustomBuffer/ScenarioBench/runs";
+  std::string results = "";
+  std::string baseline = "./CustomBuffer/ScenarioBench/baseline.tsv";
+  double tolerance = 0.1;
+  bool saveBaseline = false;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("buildDir", "The scratch directory of the ns-3 build", buildDir);
+  cmd.AddValue ("incast", "The incast executable, default the FB_FIFO one in buildDir", incast);
+  cmd.AddValue ("line", "The line executable, default the DT_FIFO one in buildDir", line);
+  cmd.AddValue ("bbr", "The BBR executable, default the one in buildDir", bbr);
+  cmd.AddValue ("cases", "Comma separated prefixes of the cases to run, e.g. incast,line-1Mbps, default all", cases);
+  cmd.AddValue ("repeats", "Number of runs of every case", repeats);
+  cmd.AddValue ("outDir", "The directory of the per run logs", outDir);
+  cmd.AddValue ("results", "The results file, default <outDir>/results.tsv", results);
+  cmd.AddValue ("baseline", "The baseline to compare with, skipped if it does not exist", baseline);
+  cmd.AddValue ("tolerance", "Allowed relative increase of wall time and peak RSS over the baseline", tolerance);
+  cmd.AddValue ("saveBaseline", "Also write the results to the baseline file", saveBaseline);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (repeats == 0, "At least one repeat is needed");
+  if (incast.empty ())
+    {
+      incast = buildDir + "/CustomBuffer/FB_FIFO/ns3.36.1-my_TrafficControl_IncastTopology_v01_1_FB-default";
+    }
+  if (line.empty ())
+    {
+      line = buildDir + "/CustomBuffer/DT_FIFO/ns3.36.1-my_TrafficControl_Line_v01_DT-default";
+    }
+  if (bbr.empty ())
+    {
+      bbr = buildDir + "/ns3.36.1-my_tcp-bbr-example-default";
+    }
+  if (results.empty ())
+    {
+      results = outDir + "/results.tsv";
+    }
+  std::string dirToSave = "mkdir -p " + outDir;
+  if (system (dirToSave.c_str ()) == -1)
+    {
+      exit (1);
+    }
+
+  // the fixed cases; keep their names stable, the baseline is keyed on them
+  std::vector<BenchCase> allCases = {
+    {"incast-4", incast, {"--nSenders=4", "--profile=true"}},
+    {"incast-16", incast, {"--nSenders=16", "--profile=true"}},
+    {"incast-64", incast, {"--nSenders=64", "--profile=true"}},
+    {"line-100Kbps", line, {"--bottleneckRate=100Kbps", "--profile=true"}},
+    {"line-1Mbps", line, {"--bottleneckRate=1Mbps", "--profile=true"}},
+    {"line-10Mbps", line, {"--senderRate=100Mbps", "--bottleneckRate=10Mbps", "--profile=true"}},
+    {"bbr-5s", bbr, {"--stopTime=5s"}},
+    {"bbr-20s", bbr, {"--stopTime=20s"}},
+    {"bbr-60s", bbr, {"--stopTime=60s"}},
+  };
+  std::vector<BenchCase> selected;
+  std::vector<std::string> prefixes = Split (cases, ',');
+  for (const BenchCase &c : allCases)
+    {
+      bool match = prefixes.empty ();
+      for (const std::string &p : prefixes)
+        {
+          match = match || c.name.compare (0, p.size (), p) == 0;
+        }
+      if (match)
+        {
+          selected.push_back (c);
+        }
+    }
+  NS_ABORT_MSG_IF (selected.empty (), "No case matches " << cases);
+
+  std::ofstream tsv (results);
+  NS_ABORT_MSG_IF (!tsv, "Can not open " << results);
+  tsv << "case\trepeats\texitStatus\twallTime\tuserTime\tsysTime\tmaxRssKb"
+      << "\tevents\tsimTime\tsimSecondsPerWallSecond\teventsPerWallSecond\n";
+
+  std::cout << "Scenario benchmark: " << selected.size () << " cases x " << repeats << " repeats" << std::endl;
+  uint32_t failed = 0;
+  for (const BenchCase &c : selected)
+    {
+      std::vector<double> wall, user, sys;
+      long maxRssKb = 0;
+      int status = 0;
+      double events = -1;
+      double simTime = -1;
+      for (uint32_t r = 0; r < repeats; ++r)
+        {
+          std::string name = outDir + "/" + c.name + "-" + std::to_string (r);
+          BenchRun run = RunCase (c, name + ".log", name + ".err");
+          if (run.status != 0)
+            {
+              status = run.status;
+              std::cout << "  " << c.name << " exited with " << run.status << ", see " << name << ".err" << std::endl;
+              continue;
+            }
+          wall.push_back (run.wallTime);
+          user.push_back (run.userTime);
+          sys.push_back (run.sysTime);
+          maxRssKb = std::max (maxRssKb, run.maxRssKb);
+          events = run.events;
+          simTime = run.simTime;
+        }
+      if (wall.empty ())
+        {
+          ++failed;
+          tsv << c.name << "\t" << repeats << "\t" << status << "\t\t\t\t\t\t\t\t\n";
+          continue;
+        }
+      double w = Median (wall);
+      tsv << c.name << "\t" << wall.size () << "\t" << status << "\t" << w << "\t" << Median (user)
+          << "\t" << Median (sys) << "\t" << maxRssKb << "\t";
+      if (events >= 0)
+        {
+          tsv << static_cast<uint64_t> (events);
+        }
+      tsv << "\t";
+      if (simTime >= 0)
+        {
+          tsv << simTime;
+        }
+      tsv << "\t";
+      if (simTime >= 0 && w > 0)
+        {
+          tsv << simTime / w;
+        }
+      tsv << "\t";
+      if (events >= 0 && w > 0)
+        {
+          tsv << events / w;
+        }
+      tsv << "\n";
+      std::cout << "  " << c.name << ":   " << w << " s, " << maxRssKb / 1024.0 << " MB";
+      if (simTime >= 0 && w > 0)
+        {
+          std::cout << ", " << simTime / w << " sim s per wall s";
+        }
+      std::cout << std::endl;
+    }
+  tsv.close ();
+  std::cout << "  Results: " << results << std::endl;
+
+  if (saveBaseline)
+    {
+      std::ifstream src (results);
+      std::ofstream dst (baseline);
+      NS_ABORT_MSG_IF (!dst, "Can not open " << baseline);
+      dst << src.rdbuf ();
+      std::cout << "  Baseline saved: " << baseline << std::endl;
+      return failed == 0 ? 0 : 1;
+    }
+
+  auto base = ReadResults (baseline);
+  if (base.empty ())
+    {
+      std::cout << "  No baseline in " << baseline << ", nothing to compare with" << std::endl;
+      return failed == 0 ? 0 : 1;
+    }
+
+  // compare with the baseline
+  auto current = ReadResults (results);
+  uint32_t regressions = 0;
+  std::cout << "Comparison with " << baseline << " (tolerance " << 100 * tolerance << "%)" << std::endl;
+  for (const BenchCase &c : selected)
+    {
+      auto b = base.find (c.name);
+      auto r = current.find (c.name);
+      if (b == base.end () || r == current.end () || r->second["wallTime"].empty ()
+          || b->second["wallTime"].empty ())
+        {
+          std::cout << "  " << c.name << ":   not in both results" << std::endl;
+          continue;
+        }
+      double wallNow = std::stod (r->second["wallTime"]);
+      double wallBase = std::stod (b->second["wallTime"]);
+      double rssNow = std::stod (r->second["maxRssKb"]);
+      double rssBase = std::stod (b->second["maxRssKb"]);
+      bool slower = wallNow > wallBase * (1 + tolerance);
+      bool larger = rssNow > rssBase * (1 + tolerance);
+      std::cout << "  " << c.name << ":   wall " << wallBase << " -> " << wallNow << " s ("
+                << (wallBase > 0 ? 100 * (wallNow / wallBase - 1) : 0) << "%), RSS "
+                << rssBase << " -> " << rssNow << " KB ("
+                << (rssBase > 0 ? 100 * (rssNow / rssBase - 1) : 0) << "%)"
+                << (slower || larger ? "  REGRESSION" : "") << std::endl;
+      if (r->second["events"] != b->second["events"])
+        {
+          std::cout << "    events changed: " << b->second["events"] << " -> " << r->second["events"]
+                    << ", the scenario does not do the same work any more" << std::endl;
+        }
+      regressions += slower || larger ? 1 : 0;
+    }
+  std::cout << "  Regressions:   " << regressions << std::endl;
+
+  return failed == 0 && regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,436 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Parameter sweep driver for the DT/FB experiments.
+//
+// Runs one simulation process per (parameter point, seed), at most nJobs at
+// a time, and merges the summaries the runs print into one results table.
+// Every parameter of the grid is passed to the simulation as --name=value,
+// so it can be a command line option of the scenario (queueCapacity,
+// bottleneckRate, nSenders, ...) or any attribute, for example:
+//
+//  ./ns3 run "CustomBuffer/Sweep/sweep-runner
+//     --program=build/scratch/CustomBuffer/FB_FIFO/ns3.36.1-FB_FIFO-default
+//     --grid=ns3::FB_FifoQueueDisc_v01::AlphaHigh=1,2,4;queueCapacity=50p,100p
+//     --seeds=5"
+//
+// The seed is passed as --RngRun. The stdout of every run goes to
+// <outDir>/run-<n>.log and its stderr to <outDir>/run-<n>.err, so the NS_LOG
+// output of a run does not get mixed with its summary.
+//
+// The summary of a run is every "key: value" line after the first "***"
+// section header, as printed by the scenarios. The results table has one row
+// per run and one column per key seen in any run, tab separated.
+//
+// With --columnar=1 every run also gets --results=<outDir>/run-<n>.cols, the
+// per flow and queue disc statistics in the columnar binary format, which
+// CustomBuffer/Results/results-tool aggregates over the whole sweep.
+//
+// With --traceDirs=1 every run also gets --traceDir=<outDir>/run-<n>, so the
+// queue traces of the runs do not get appended to the same files; the
+// CustomBuffer/Trace_Aggregate/trace-aggregate tool summarizes them. Only the
+// scenarios that write queue traces have --traceDir (the DT line one, not the
+// incast and fabric ones, which write none); the sweep checks the --PrintHelp
+// output of the program and refuses to start otherwise.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SweepRunner");
+
+struct SweepParam
+{
+  std::string name;
+  std::vector<std::string> values;
+};
+
+struct SweepJob
+{
+  uint32_t point;                     //!< index of the parameter point
+  uint32_t run;                       //!< RngRun
+  std::vector<std::string> values;    //!< one value per SweepParam
+  std::string logFile;
+  std::string errFile;
+  std::string resultsFile;            //!< columnar results, empty for none
+  std::string traceDir;               //!< queue trace directory, empty for the default
+  pid_t pid {-1};
+  int status {-1};
+  double wallTime {0};                //!< [s]
+  std::chrono::steady_clock::time_point start;
+};
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::string item;
+  std::istringstream is (s);
+  while (std::getline (is, item, sep))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+// trim both ends and replace every whitespace run (tabs included) with one space
+static std::string
+Normalize (const std::string &s)
+{
+  std::string out;
+  bool space = false;
+  for (char c : s)
+    {
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        {
+          space = !out.empty ();
+          continue;
+        }
+      if (space)
+        {
+          out += ' ';
+          space = false;
+        }
+      out += c;
+    }
+  return out;
+}
+
+// "name=v1,v2;name2=v3" -> {name: [v1, v2]}, {name2: [v3]}
+static std::vector<SweepParam>
+ParseGrid (const std::string &grid)
+{
+  std::vector<SweepParam> params;
+  for (const std::string &entry : Split (grid, ';'))
+    {
+      std::size_t eq = entry.find ('=');
+      NS_ABORT_MSG_IF (eq == std::string::npos || eq == 0, "Bad grid entry " << entry << ", expected name=v1,v2,...");
+      SweepParam p;
+      p.name = entry.substr (0, eq);
+      p.values = Split (entry.substr (eq + 1), ',');
+      NS_ABORT_MSG_IF (p.values.empty (), "No values for " << p.name);
+      params.push_back (p);
+    }
+  return params;
+}
+
+static pid_t
+StartJob (const std::string &program, const std::vector<std::string> &fixedArgs,
+          const std::vector<SweepParam> &params, SweepJob &job)
+{
+  std::vector<std::string> args;
+  args.push_back (program);
+  args.insert (args.end (), fixedArgs.begin (), fixedArgs.end ());
+  for (uint32_t i = 0; i < params.size (); ++i)
+    {
+      args.push_back ("--" + params[i].name + "=" + job.values[i]);
+    }
+  args.push_back ("--RngRun=" + std::to_string (job.run));
+  if (!job.resultsFile.empty ())
+    {
+      args.push_back ("--results=" + job.resultsFile);
+    }
+  if (!job.traceDir.empty ())
+    {
+      args.push_back ("--traceDir=" + job.traceDir);
+    }
+
+  // everything the child needs is built before the fork
+  std::vector<char *> argv;
+  for (std::string &a : args)
+    {
+      argv.push_back (&a[0]);
+    }
+  argv.push_back (nullptr);
+
+  std::cout.flush ();
+  job.start = std::chrono::steady_clock::now ();
+  pid_t pid = fork ();
+  if (pid == 0)
+    {
+      int out = open (job.logFile.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      int err = open (job.errFile.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (out < 0 || err < 0 || dup2 (out, STDOUT_FILENO) < 0 || dup2 (err, STDERR_FILENO) < 0)
+        {
+          _exit (126);
+        }
+      close (out);
+      close (err);
+      execv (argv[0], argv.data ());
+      _exit (127);
+    }
+  NS_ABORT_MSG_IF (pid < 0, "fork failed");
+  return pid;
+}
+
+// whether the --PrintHelp output of the program lists the option
+static bool
+HasOption (const std::string &program, const std::string &option)
+{
+  FILE *help = popen (("'" + program + "' --PrintHelp 2>/dev/null").c_str (), "r");
+  if (!help)
+    {
+      return false;
+    }
+  std::string text;
+  char buffer[4096];
+  for (std::size_t n; (n = fread (buffer, 1, sizeof (buffer), help)) > 0;)
+    {
+      text.append (buffer, n);
+    }
+  pclose (help);
+  return text.find ("--" + option + ":") != std::string::npos;
+}
+
+// collect the "key: value" lines after the first "***" header
+static std::map<std::string, std::string>
+ParseSummary (const std::string &logFile, std::vector<std::string> &columns)
+{
+  std::map<std::string, std::string> summary;
+  std::ifstream log (logFile);
+  std::string line;
+  bool inSummary = false;
+  while (std::getline (log, line))
+    {
+      if (line.find ("***") != std::string::npos)
+        {
+          inSummary = true;
+          continue;
+        }
+      std::size_t colon = line.find (':');
+      if (!inSummary || colon == std::string::npos)
+        {
+          continue;
+        }
+      std::string key = Normalize (line.substr (0, colon));
+      std::string value = Normalize (line.substr (colon + 1));
+      if (key.empty () || value.empty ())
+        {
+          continue;
+        }
+      if (summary.find (key) == summary.end ())
+        {
+          bool known = false;
+          for (const std::string &c : columns)
+            {
+              known = known || c == key;
+            }
+          if (!known)
+            {
+              columns.push_back (key);
+            }
+        }
+      summary[key] = value;
+    }
+  return summary;
+}
+
+int main (int argc, char *argv[])
+{
+  std::string program;
+  std::string grid;
+  std::string fixedArgs;
+  uint32_t seeds = 1;
+  uint32_t firstRun = 1;
+  uint32_t nJobs = std::thread::hardware_concurrency ();
+  std::string outDir = "./CustomBuffer/Sweep/runs";
+  std::string results = "";
+  bool columnar = false;
+  bool traceDirs = false;
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("program", "The simulation executable to run", program);
+  cmd.AddValue ("grid", "The parameter grid: name=v1,v2;name2=v3,...", grid);
+  cmd.AddValue ("args", "Arguments passed unchanged to every run, space separated", fixedArgs);
+  cmd.AddValue ("seeds", "Number of seeds (RngRun values) for every parameter point", seeds);
+  cmd.AddValue ("firstRun", "The first RngRun value", firstRun);
+  cmd.AddValue ("nJobs", "Max number of simulations running at the same time, default one per core", nJobs);
+  cmd.AddValue ("outDir", "The directory of the per run logs", outDir);
+  cmd.AddValue ("results", "The merged results table, default <outDir>/results.tsv", results);
+  cmd.AddValue ("columnar", "Also have every run write <outDir>/run-<n>.cols with --results", columnar);
+  cmd.AddValue ("traceDirs", "Have every run write its queue traces to <outDir>/run-<n> with --traceDir", traceDirs);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (program.empty (), "--program is required");
+  NS_ABORT_MSG_IF (seeds == 0, "At least one seed is needed");
+  NS_ABORT_MSG_IF (traceDirs && !HasOption (program, "traceDir"),
+                   program << " has no --traceDir option, it can not be run with --traceDirs");
+  if (nJobs == 0)
+    {
+      nJobs = 1;
+    }
+  if (results.empty ())
+    {
+      results = outDir + "/results.tsv";
+    }
+  std::string dirToSave = "mkdir -p " + outDir;
+  if (system (dirToSave.c_str ()) == -1)
+    {
+      exit (1);
+    }
+
+  std::vector<SweepParam> params = ParseGrid (grid);
+  std::vector<std::string> args;
+  std::istringstream is (fixedArgs);
+  for (std::string a; is >> a;)
+    {
+      args.push_back (a);
+    }
+
+  // the cartesian product of the grid, the last parameter changes fastest
+  uint32_t nPoints = 1;
+  for (const SweepParam &p : params)
+    {
+      nPoints *= p.values.size ();
+    }
+  std::vector<SweepJob> jobs;
+  jobs.reserve (nPoints * seeds);
+  for (uint32_t point = 0; point < nPoints; ++point)
+    {
+      std::vector<std::string> values (params.size ());
+      uint32_t rest = point;
+      for (uint32_t i = params.size (); i-- > 0;)
+        {
+          values[i] = params[i].values[rest % params[i].values.size ()];
+          rest /= params[i].values.size ();
+        }
+      for (uint32_t s = 0; s < seeds; ++s)
+        {
+          SweepJob job;
+          job.point = point;
+          job.run = firstRun + s;
+          job.values = values;
+          std::string name = outDir + "/run-" + std::to_string (jobs.size ());
+          job.logFile = name + ".log";
+          job.errFile = name + ".err";
+          job.resultsFile = columnar ? name + ".cols" : "";
+          job.traceDir = traceDirs ? name : "";
+          jobs.push_back (job);
+        }
+    }
+
+  std::cout << "Sweep: " << nPoints << " points x " << seeds << " seeds = " << jobs.size ()
+            << " runs on " << nJobs << " workers" << std::endl;
+
+  // job queue: keep nJobs children running, start the next one as soon as one exits
+  auto sweepStart = std::chrono::steady_clock::now ();
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  uint32_t done = 0;
+  uint32_t failed = 0;
+  while (done < jobs.size ())
+    {
+      while (running.size () < nJobs && next < jobs.size ())
+        {
+          jobs[next].pid = StartJob (program, args, params, jobs[next]);
+          running[jobs[next].pid] = next;
+          ++next;
+        }
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          NS_ABORT_MSG_IF (errno != EINTR, "waitpid failed");
+          continue;
+        }
+      auto it = running.find (pid);
+      if (it == running.end ())
+        {
+          continue;
+        }
+      SweepJob &job = jobs[it->second];
+      running.erase (it);
+      job.status = WIFEXITED (status) ? WEXITSTATUS (status) : 128 + WTERMSIG (status);
+      job.wallTime = std::chrono::duration<double> (std::chrono::steady_clock::now () - job.start).count ();
+      ++done;
+      if (job.status != 0)
+        {
+          ++failed;
+          std::cout << "  run " << (&job - &jobs[0]) << " exited with " << job.status
+                    << ", see " << job.errFile << std::endl;
+        }
+      NS_LOG_INFO (done << "/" << jobs.size () << " done");
+    }
+  double sweepTime = std::chrono::duration<double> (std::chrono::steady_clock::now () - sweepStart).count ();
+
+  // merge the summaries, the columns are in the order they are first seen
+  std::vector<std::string> columns;
+  std::vector<std::map<std::string, std::string>> summaries;
+  summaries.reserve (jobs.size ());
+  double cpuTime = 0;
+  for (const SweepJob &job : jobs)
+    {
+      summaries.push_back (ParseSummary (job.logFile, columns));
+      cpuTime += job.wallTime;
+    }
+
+  std::ofstream tsv (results);
+  NS_ABORT_MSG_IF (!tsv, "Can not open " << results);
+  tsv << "point\tRngRun";
+  for (const SweepParam &p : params)
+    {
+      tsv << "\t" << p.name;
+    }
+  tsv << "\texitStatus\twallTime";
+  for (const std::string &c : columns)
+    {
+      tsv << "\t" << c;
+    }
+  tsv << "\n";
+  for (uint32_t j = 0; j < jobs.size (); ++j)
+    {
+      const SweepJob &job = jobs[j];
+      tsv << job.point << "\t" << job.run;
+      for (const std::string &v : job.values)
+        {
+          tsv << "\t" << v;
+        }
+      tsv << "\t" << job.status << "\t" << job.wallTime;
+      for (const std::string &c : columns)
+        {
+          auto it = summaries[j].find (c);
+          tsv << "\t" << (it == summaries[j].end () ? "" : it->second);
+        }
+      tsv << "\n";
+    }
+  tsv.close ();
+
+  std::cout << "Sweep done: " << jobs.size () - failed << " ok, " << failed << " failed" << std::endl;
+  std::cout << "  Wall time: " << sweepTime << " s, sum of run times: " << cpuTime << " s" << std::endl;
+  std::cout << "  Results: " << results << std::endl;
+
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,468 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+// Summarizes the queue traces of many runs in one table, one row per run
+// directory and then the mean, stddev, min and max of every column over the
+// runs. A run directory holds the traces of the High and Low Priority class,
+// as written to DT_FifoQueueDisc_v02 or to --traceDir of a sweep run:
+//  - meanOcc<Class>:      the time average of <class>PriorityPacketsInQueueTrace;
+//  - maxOcc<Class>:       its max;
+//  - thresholdHit<Class>: the fraction of the time the per class occupancy
+//                         is at or above <class>PriorityQueueThreshold. This
+//                         is not the time the class gets dropped: admission
+//                         compares the total occupancy + 1 with the threshold;
+// over the time range of the traces of the run, or tStart to tEnd. When the
+// columnar results of the run are found, <run>/results.cols or <run>.cols as
+// written by the sweep with --columnar=1, the table also has:
+//  - dropRatio:           dropped / received packets of the queue discs;
+//  - dropRatio<Class>:    dropped / (dropped + dequeued) packets of the class,
+//                         the dequeued ones counted by the sojourn histograms;
+//  - goodput[Mice|Elephants]: received bytes of the flows (of the class) over
+//                         the time from their first sent to their last
+//                         received packet, in Mbit/s.
+// A value that can not be computed is written as "-". For example:
+//
+//  ./ns3 run "CustomBuffer/Trace_Aggregate/trace-aggregate
+//     --runs=CustomBuffer/Sweep/runs/run-* --out=CustomBuffer/Sweep/runs/traces.tsv"
+//
+// The runs are summarized nThreads at a time, every trace in one pass over
+// its memory mapping.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include <glob.h>
+
+#include "ns3/core-module.h"
+#include "../trace-reader.h"
+#include "../columnar-results.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TraceAggregate");
+
+static const double NO_VALUE = std::numeric_limits<double>::quiet_NaN ();
+
+static const char *CLASS_NAMES[] = {"High", "Low"};
+static const char *TRACE_PREFIXES[] = {"highPriority", "lowPriority"};
+
+// the columns of the table, in order
+static const char *COLUMN_NAMES[] = {
+  "span", "meanOccHigh", "meanOccLow", "maxOccHigh", "maxOccLow",
+  "thresholdHitHigh", "thresholdHitLow", "dropRatio", "dropRatioHigh", "dropRatioLow",
+  "goodput", "goodputMice", "goodputElephants"
+};
+
+static const uint32_t N_COLUMNS = sizeof (COLUMN_NAMES) / sizeof (COLUMN_NAMES[0]);
+
+enum Column
+{
+  SPAN = 0,
+  MEAN_OCC = 1,          //!< + class
+  MAX_OCC = 3,           //!< + class
+  THRESHOLD_HIT = 5,     //!< + class
+  DROP_RATIO = 7,
+  DROP_RATIO_CLASS = 8,  //!< + class
+  GOODPUT = 10,
+  GOODPUT_FLOWS = 11     //!< + flow class (0 mice, 1 elephants)
+};
+
+struct RunSummary
+{
+  std::string run;
+  double value[N_COLUMNS];
+};
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::string item;
+  std::istringstream is (s);
+  while (std::getline (is, item, sep))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+// the directories matching any of the space separated patterns, sorted
+static std::vector<std::string>
+GlobDirectories (const std::string &patterns)
+{
+  std::vector<std::string> dirs;
+  for (const std::string &pattern : Split (patterns, ' '))
+    {
+      glob_t g;
+      if (glob (pattern.c_str (), GLOB_ONLYDIR, nullptr, &g) == 0)
+        {
+          for (std::size_t i = 0; i < g.gl_pathc; ++i)
+            {
+              struct stat st;
+              if (stat (g.gl_pathv[i], &st) == 0 && S_ISDIR (st.st_mode))
+                {
+                  dirs.push_back (g.gl_pathv[i]);
+                }
+            }
+        }
+      globfree (&g);
+    }
+  std::sort (dirs.begin (), dirs.end ());
+  dirs.erase (std::unique (dirs.begin (), dirs.end ()), dirs.end ());
+  return dirs;
+}
+
+// integrate the occupancy of a class over [t0, t1], both traces are step
+// functions read in one merged pass; no threshold trace gives no hit fraction
+static void
+SummarizeClass (const MappedFile &occupancy, const MappedFile &threshold, double t0, double t1,
+                double &meanOcc, double &maxOcc, double &thresholdHit)
+{
+  TraceCursor occ (occupancy);
+  TraceCursor thr (threshold);
+  double o = 0;
+  double th = std::numeric_limits<double>::infinity ();
+  double tO, vO, tT, vT;
+  bool haveO = occ.Next (tO, vO);
+  bool haveT = thr.Next (tT, vT);
+  double last = t0;
+  double area = 0;
+  double hit = 0;
+  double max = 0;
+  auto advance = [&] (double t) {
+    t = std::min (t, t1);
+    if (t > last)
+      {
+        area += o * (t - last);
+        hit += o >= th ? t - last : 0;
+        max = std::max (max, o);
+        last = t;
+      }
+  };
+  while (haveO || haveT)
+    {
+      bool takeO = haveO && (!haveT || tO <= tT);
+      double t = takeO ? tO : tT;
+      if (t > t1)
+        {
+          break;
+        }
+      advance (t);
+      if (takeO)
+        {
+          o = vO;
+          max = t >= t0 ? std::max (max, o) : max;
+          haveO = occ.Next (tO, vO);
+        }
+      else
+        {
+          th = vT;
+          haveT = thr.Next (tT, vT);
+        }
+    }
+  advance (t1);
+  meanOcc = t1 > t0 ? area / (t1 - t0) : NO_VALUE;
+  maxOcc = max;
+  thresholdHit = threshold.GetData () && t1 > t0 ? hit / (t1 - t0) : NO_VALUE;
+}
+
+// the drop ratios and the goodputs from the columnar results of a run
+static void
+SummarizeResults (const ColumnarResults &results, double *value)
+{
+  const ColumnarTable *queueDiscs = results.GetTable ("queueDiscs");
+  if (queueDiscs)
+    {
+      double received = 0;
+      double dropped = 0;
+      double droppedClass[2] = {0, 0};
+      double dequeuedClass[2] = {0, 0};
+      int32_t receivedColumn = queueDiscs->FindColumn ("nTotalReceivedPackets");
+      int32_t droppedColumn = queueDiscs->FindColumn ("nTotalDroppedPackets");
+      int32_t droppedClassColumn[2] = {
+        queueDiscs->FindColumn ("nTotalDroppedPacketsBeforeEnqueueHighPriority"),
+        queueDiscs->FindColumn ("nTotalDroppedPacketsBeforeEnqueueLowPriority")};
+      for (uint64_t row = 0; row < queueDiscs->GetNRows (); ++row)
+        {
+          received += receivedColumn < 0 ? 0 : queueDiscs->GetDouble (receivedColumn, row);
+          dropped += droppedColumn < 0 ? 0 : queueDiscs->GetDouble (droppedColumn, row);
+          for (uint32_t c = 0; c < 2; ++c)
+            {
+              droppedClass[c] += droppedClassColumn[c] < 0 ? 0 : queueDiscs->GetDouble (droppedClassColumn[c], row);
+            }
+        }
+      // every dequeued packet is in a bucket of the sojourn histogram of its class
+      for (uint32_t i = 0; i < queueDiscs->GetNColumns (); ++i)
+        {
+          const std::string &name = queueDiscs->GetColumnName (i);
+          for (uint32_t c = 0; c < 2; ++c)
+            {
+              std::string prefix = std::string ("sojourn") + CLASS_NAMES[c] + ":";
+              if (name.compare (0, prefix.size (), prefix) != 0)
+                {
+                  continue;
+                }
+              for (uint64_t row = 0; row < queueDiscs->GetNRows (); ++row)
+                {
+                  dequeuedClass[c] += queueDiscs->GetDouble (i, row);
+                }
+            }
+        }
+      value[DROP_RATIO] = received > 0 ? dropped / received : NO_VALUE;
+      for (uint32_t c = 0; c < 2; ++c)
+        {
+          double arrived = droppedClass[c] + dequeuedClass[c];
+          value[DROP_RATIO_CLASS + c] = arrived > 0 ? droppedClass[c] / arrived : NO_VALUE;
+        }
+    }
+
+  const ColumnarTable *flows = results.GetTable ("flows");
+  if (flows)
+    {
+      int32_t classColumn = flows->FindColumn ("class");
+      int32_t txColumn = flows->FindColumn ("txPackets");
+      int32_t rxColumn = flows->FindColumn ("rxPackets");
+      int32_t rxBytesColumn = flows->FindColumn ("rxBytes");
+      int32_t firstTxColumn = flows->FindColumn ("timeFirstTxPacket");
+      int32_t lastRxColumn = flows->FindColumn ("timeLastRxPacket");
+      if (classColumn < 0 || txColumn < 0 || rxColumn < 0 || rxBytesColumn < 0
+          || firstTxColumn < 0 || lastRxColumn < 0)
+        {
+          return;
+        }
+      // all flows, mice, elephants
+      double rxBytes[3] = {0, 0, 0};
+      double firstTx[3];
+      double lastRx[3];
+      std::fill (firstTx, firstTx + 3, std::numeric_limits<double>::infinity ());
+      std::fill (lastRx, lastRx + 3, -std::numeric_limits<double>::infinity ());
+      for (uint64_t row = 0; row < flows->GetNRows (); ++row)
+        {
+          uint32_t groups[2] = {0, flows->GetUint (classColumn, row) == 0 ? 1u : 2u};
+          for (uint32_t g : groups)
+            {
+              rxBytes[g] += flows->GetDouble (rxBytesColumn, row);
+              if (flows->GetUint (txColumn, row) > 0)
+                {
+                  firstTx[g] = std::min (firstTx[g], flows->GetDouble (firstTxColumn, row));
+                }
+              if (flows->GetUint (rxColumn, row) > 0)
+                {
+                  lastRx[g] = std::max (lastRx[g], flows->GetDouble (lastRxColumn, row));
+                }
+            }
+        }
+      for (uint32_t g = 0; g < 3; ++g)
+        {
+          // the times are in ns
+          double goodput = lastRx[g] > firstTx[g] ? rxBytes[g] * 8e3 / (lastRx[g] - firstTx[g]) : NO_VALUE;
+          value[g == 0 ? GOODPUT : GOODPUT_FLOWS + g - 1] = goodput;
+        }
+    }
+}
+
+static RunSummary
+SummarizeRun (const std::string &run, const std::string &resultsName, double tStart, double tEnd)
+{
+  RunSummary summary;
+  summary.run = run;
+  std::fill (summary.value, summary.value + N_COLUMNS, NO_VALUE);
+
+  MappedFile occupancy[2] = {MappedFile (run + "/" + TRACE_PREFIXES[0] + "PacketsInQueueTrace.dat"),
+                             MappedFile (run + "/" + TRACE_PREFIXES[1] + "PacketsInQueueTrace.dat")};
+  MappedFile threshold[2] = {MappedFile (run + "/" + TRACE_PREFIXES[0] + "QueueThreshold.dat"),
+                             MappedFile (run + "/" + TRACE_PREFIXES[1] + "QueueThreshold.dat")};
+
+  // by default from the first queued packet to the last sample of any trace
+  double t0 = std::numeric_limits<double>::infinity ();
+  double t1 = -std::numeric_limits<double>::infinity ();
+  for (uint32_t c = 0; c < 2; ++c)
+    {
+      double first, last;
+      if (GetTextTimeRange (occupancy[c], first, last))
+        {
+          t0 = std::min (t0, first);
+          t1 = std::max (t1, last);
+        }
+      if (GetTextTimeRange (threshold[c], first, last))
+        {
+          t1 = std::max (t1, last);
+        }
+    }
+  t0 = tStart >= 0 ? tStart : t0;
+  t1 = tEnd >= 0 ? tEnd : t1;
+  if (t1 > t0)
+    {
+      summary.value[SPAN] = t1 - t0;
+      for (uint32_t c = 0; c < 2; ++c)
+        {
+          if (occupancy[c].GetData ())
+            {
+              SummarizeClass (occupancy[c], threshold[c], t0, t1, summary.value[MEAN_OCC + c],
+                              summary.value[MAX_OCC + c], summary.value[THRESHOLD_HIT + c]);
+            }
+        }
+    }
+
+  std::string dir = run;
+  while (dir.size () > 1 && dir.back () == '/')
+    {
+      dir.pop_back ();
+    }
+  ColumnarResults results;
+  if (results.Read (dir + "/" + resultsName) || results.Read (dir + ".cols"))
+    {
+      SummarizeResults (results, summary.value);
+    }
+  return summary;
+}
+
+static void
+WriteValue (std::ostream &os, double value)
+{
+  if (std::isnan (value))
+    {
+      os << "\t-";
+    }
+  else
+    {
+      os << "\t" << value;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string runs = "./CustomBuffer/Trace_Plots/DT_FifoQueueDisc_v02";
+  std::string resultsName = "results.cols";
+  double tStart = -1;
+  double tEnd = -1;
+  std::string out;
+  uint32_t nThreads = std::thread::hardware_concurrency ();
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("runs", "The run directories, space separated glob patterns", runs);
+  cmd.AddValue ("results", "The columnar results file in a run directory, else <run>.cols is tried", resultsName);
+  cmd.AddValue ("tStart", "Start of the time range in s, default the first queued packet of a run", tStart);
+  cmd.AddValue ("tEnd", "End of the time range in s, default the last sample of a run", tEnd);
+  cmd.AddValue ("out", "The output file, default stdout", out);
+  cmd.AddValue ("nThreads", "Number of runs summarized at the same time, default one per core", nThreads);
+  cmd.Parse (argc, argv);
+
+  std::vector<std::string> dirs = GlobDirectories (runs);
+  NS_ABORT_MSG_IF (dirs.empty (), "No directory matches " << runs);
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+
+  // every thread takes the next run until there is none left
+  std::vector<RunSummary> summaries (dirs.size ());
+  std::atomic<uint32_t> next (0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < std::min<std::size_t> (nThreads, dirs.size ()); ++t)
+    {
+      threads.emplace_back ([&] () {
+        for (uint32_t r = next++; r < dirs.size (); r = next++)
+          {
+            summaries[r] = SummarizeRun (dirs[r], resultsName, tStart, tEnd);
+          }
+      });
+    }
+  for (std::thread &t : threads)
+    {
+      t.join ();
+    }
+
+  std::ofstream file;
+  if (!out.empty ())
+    {
+      file.open (out);
+      NS_ABORT_MSG_IF (!file, "Can not open " << out);
+    }
+  std::ostream &os = out.empty () ? std::cout : file;
+
+  os << "run";
+  for (const char *name : COLUMN_NAMES)
+    {
+      os << "\t" << name;
+    }
+  os << "\n";
+  for (const RunSummary &s : summaries)
+    {
+      os << s.run;
+      for (double v : s.value)
+        {
+          WriteValue (os, v);
+        }
+      os << "\n";
+    }
+
+  // over the runs that have the value
+  double count[N_COLUMNS] = {};
+  double sum[N_COLUMNS] = {};
+  double sumSquares[N_COLUMNS] = {};
+  double min[N_COLUMNS];
+  double max[N_COLUMNS];
+  std::fill (min, min + N_COLUMNS, std::numeric_limits<double>::infinity ());
+  std::fill (max, max + N_COLUMNS, -std::numeric_limits<double>::infinity ());
+  for (const RunSummary &s : summaries)
+    {
+      for (uint32_t i = 0; i < N_COLUMNS; ++i)
+        {
+          double v = s.value[i];
+          if (std::isnan (v))
+            {
+              continue;
+            }
+          count[i]++;
+          sum[i] += v;
+          sumSquares[i] += v * v;
+          min[i] = std::min (min[i], v);
+          max[i] = std::max (max[i], v);
+        }
+    }
+  const char *rows[] = {"mean", "stddev", "min", "max"};
+  for (uint32_t r = 0; r < 4; ++r)
+    {
+      os << rows[r];
+      for (uint32_t i = 0; i < N_COLUMNS; ++i)
+        {
+          double mean = count[i] > 0 ? sum[i] / count[i] : NO_VALUE;
+          double values[] = {mean,
+                             count[i] > 1 ? std::sqrt (std::max (0.0, (sumSquares[i] - count[i] * mean * mean) / (count[i] - 1))) : NO_VALUE,
+                             count[i] > 0 ? min[i] : NO_VALUE,
+                             count[i] > 0 ? max[i] : NO_VALUE};
+          WriteValue (os, values[r]);
+        }
+      os << "\n";
+    }
+  os.flush ();
+
+  std::cerr << "Summarized " << dirs.size () << " runs" << std::endl;
+  return 0;
+}
@@ -15,11 +15,37 @@
  *
  */
 
+// Reduces the queue traces of a run to plot resolution, then plots them.
+//
+// A trace is either text, one "time value" line per sample as written by the
+// Tc*PacketsInQueueTrace and QueueThreshold*Trace callbacks, or binary (.bin),
+// pairs of host order doubles (time in s, value). The file is memory mapped
+// and split in nThreads chunks parsed in parallel. The time range is cut in
+// width pixel columns and every column keeps its first, min, max and last
+// sample; the merged columns are written as "time value" lines in time order
+// to <outDir>/<trace>.dat. The samples in between are left out, so drawn with
+// lines this is the min/max envelope of the full trace per pixel column, from
+// at most 4 * width points, and a run of 10^8 samples is reduced in the time
+// it takes to read the file once. The kept lines of a text trace are copied
+// verbatim, the samples of a binary one written with all their digits.
+//
+// The gnuplot scripts read the reduced traces and write their PNG files in
+// the directory given as plotDir, <outDir> here:
+//
+//  ./ns3 run "CustomBuffer/Trace_Plots/PlotTraces --width=4000
+//     --gnuplot=gnuplotScriptHighPriority,gnuplotScriptLowPriority"
+
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <limits>
 
 #include "ns3/core-module.h"
+#include "../trace-reader.h"
 // #include "ns3/applications-module.h"
 // #include "ns3/network-module.h"
 // #include "ns3/internet-module.h"
@@ -33,18 +59,342 @@
 
 using namespace ns3;
 
+NS_LOG_COMPONENT_DEFINE ("PlotTraces");
+
 std::string dir = "./CustomBuffer/Trace_Plots/";
 std::string queue_disc_type = "DT_FifoQueueDisc_v02";
 
+// the samples of a trace falling in one pixel column, the min and the max
+// with their position among them so they are written in sample order, and
+// the line of every kept sample of a text trace, 0 for a binary one
+struct PlotColumn
+{
+  uint64_t n {0};
+  double tFirst, vFirst;
+  const char *lFirst;
+  uint64_t iMin;
+  double tMin, vMin;
+  const char *lMin;
+  uint64_t iMax;
+  double tMax, vMax;
+  const char *lMax;
+  double tLast, vLast;
+  const char *lLast;
+
+  void
+  Add (double t, double v, const char *line)
+  {
+    if (n == 0)
+      {
+        tFirst = tMin = tMax = t;
+        vFirst = vMin = vMax = v;
+        lFirst = lMin = lMax = line;
+        iMin = iMax = 0;
+      }
+    else if (v < vMin)
+      {
+        iMin = n;
+        tMin = t;
+        vMin = v;
+        lMin = line;
+      }
+    else if (v > vMax)
+      {
+        iMax = n;
+        tMax = t;
+        vMax = v;
+        lMax = line;
+      }
+    tLast = t;
+    vLast = v;
+    lLast = line;
+    n++;
+  }
+
+  // merge the samples of the same column of a later chunk
+  void
+  Merge (const PlotColumn &later)
+  {
+    if (later.n == 0)
+      {
+        return;
+      }
+    if (n == 0)
+      {
+        *this = later;
+        return;
+      }
+    if (later.vMin < vMin)
+      {
+        iMin = n + later.iMin;
+        tMin = later.tMin;
+        vMin = later.vMin;
+        lMin = later.lMin;
+      }
+    if (later.vMax > vMax)
+      {
+        iMax = n + later.iMax;
+        tMax = later.tMax;
+        vMax = later.vMax;
+        lMax = later.lMax;
+      }
+    tLast = later.tLast;
+    vLast = later.vLast;
+    lLast = later.lLast;
+    n += later.n;
+  }
+};
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::string item;
+  std::istringstream is (s);
+  while (std::getline (is, item, sep))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+struct TraceRange
+{
+  double tStart;
+  double tEnd;
+};
+
+// the times of the first and the last sample of a trace
+static bool
+GetTimeRange (const MappedFile &file, bool binary, TraceRange &range)
+{
+  const char *data = file.GetData ();
+  std::size_t size = file.GetSize ();
+  if (binary)
+    {
+      if (size < 2 * sizeof (double))
+        {
+          return false;
+        }
+      std::size_t last = (size / (2 * sizeof (double)) - 1) * 2 * sizeof (double);
+      memcpy (&range.tStart, data, sizeof (double));
+      memcpy (&range.tEnd, data + last, sizeof (double));
+      return true;
+    }
+  return GetTextTimeRange (file, range.tStart, range.tEnd);
+}
+
+// reduce the samples of [begin, end) of the file to the pixel columns
+static void
+ReduceChunk (const char *begin, const char *end, bool binary, const TraceRange &range,
+             std::vector<PlotColumn> &columns)
+{
+  const uint32_t width = columns.size ();
+  const double scale = range.tEnd > range.tStart ? width / (range.tEnd - range.tStart) : 0;
+  double t, v;
+  for (const char *p = begin; p < end;)
+    {
+      const char *line = binary ? 0 : p;
+      if (binary)
+        {
+          memcpy (&t, p, sizeof (double));
+          memcpy (&v, p + sizeof (double), sizeof (double));
+          p += 2 * sizeof (double);
+        }
+      else if (!ParseLine (p, end, t, v))
+        {
+          continue;
+        }
+      if (t < range.tStart || t > range.tEnd)
+        {
+          continue;
+        }
+      uint32_t c = std::min<uint32_t> ((t - range.tStart) * scale, width - 1);
+      columns[c].Add (t, v, line);
+    }
+}
+
+// the start of chunk i of n, at a line (text) or record (binary) boundary
+static const char *
+GetChunkStart (const MappedFile &file, bool binary, uint32_t i, uint32_t n)
+{
+  const char *data = file.GetData ();
+  std::size_t size = file.GetSize ();
+  if (binary)
+    {
+      std::size_t records = size / (2 * sizeof (double));
+      return data + records * i / n * 2 * sizeof (double);
+    }
+  std::size_t pos = size * i / n;
+  while (pos > 0 && pos < size && data[pos - 1] != '\n')
+    {
+      ++pos;
+    }
+  return data + pos;
+}
+
+// reduce one trace file, returns the number of samples
+static uint64_t
+ReduceTrace (const std::string &in, const std::string &out, uint32_t width,
+             double tStart, double tEnd, uint32_t nThreads, uint64_t &nPoints)
+{
+  bool binary = in.size () > 4 && in.compare (in.size () - 4, 4, ".bin") == 0;
+  MappedFile file (in);
+  TraceRange range;
+  if (!file.GetData () || !GetTimeRange (file, binary, range))
+    {
+      std::cerr << "Skipping " << in << ": no samples" << std::endl;
+      return 0;
+    }
+  if (tStart >= 0)
+    {
+      range.tStart = tStart;
+    }
+  if (tEnd >= 0)
+    {
+      range.tEnd = tEnd;
+    }
+
+  // every thread reduces its own chunk to its own columns, merged in time order
+  uint32_t nChunks = std::max<std::size_t> (1, std::min<std::size_t> (nThreads, file.GetSize () >> 16));
+  std::vector<std::vector<PlotColumn> > partial (nChunks, std::vector<PlotColumn> (width));
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < nChunks; ++i)
+    {
+      threads.emplace_back (ReduceChunk, GetChunkStart (file, binary, i, nChunks),
+                            GetChunkStart (file, binary, i + 1, nChunks), binary,
+                            std::cref (range), std::ref (partial[i]));
+    }
+  for (std::thread &t : threads)
+    {
+      t.join ();
+    }
+  for (uint32_t i = 1; i < nChunks; ++i)
+    {
+      for (uint32_t c = 0; c < width; ++c)
+        {
+          partial[0][c].Merge (partial[i][c]);
+        }
+    }
+
+  std::vector<char> buffer (1 << 20);
+  std::ofstream os;
+  os.rdbuf ()->pubsetbuf (buffer.data (), buffer.size ());
+  os.open (out, std::ios::out | std::ios::trunc);
+  NS_ABORT_MSG_IF (!os, "Can not open " << out);
+  // the shortest precision that gives back the doubles of a binary trace
+  os.precision (std::numeric_limits<double>::max_digits10);
+  const char *fileEnd = file.GetData () + file.GetSize ();
+  uint64_t nSamples = 0;
+  nPoints = 0;
+  for (const PlotColumn &c : partial[0])
+    {
+      if (c.n == 0)
+        {
+          continue;
+        }
+      nSamples += c.n;
+      // first, min, max and last in sample order, each sample once
+      struct
+      {
+        uint64_t i;
+        double t, v;
+        const char *line;
+      } points[4] = {{0, c.tFirst, c.vFirst, c.lFirst}, {c.iMin, c.tMin, c.vMin, c.lMin},
+                     {c.iMax, c.tMax, c.vMax, c.lMax}, {c.n - 1, c.tLast, c.vLast, c.lLast}};
+      if (points[1].i > points[2].i)
+        {
+          std::swap (points[1], points[2]);
+        }
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          if (i > 0 && points[i].i == points[i - 1].i)
+            {
+              continue;
+            }
+          if (points[i].line)
+            {
+              const char *eol = static_cast<const char *> (memchr (points[i].line, '\n', fileEnd - points[i].line));
+              os.write (points[i].line, (eol ? eol : fileEnd) - points[i].line);
+              os << "\n";
+            }
+          else
+            {
+              os << points[i].t << " " << points[i].v << "\n";
+            }
+          nPoints++;
+        }
+    }
+  os.close ();
+  NS_ABORT_MSG_IF (!os, "Error writing " << out);
+  return nSamples;
+}
 
 int main (int argc, char *argv[])
-{ 
+{
+  std::string traces = "highPriorityPacketsInQueueTrace.dat,lowPriorityPacketsInQueueTrace.dat,"
+                       "highPriorityQueueThreshold.dat,lowPriorityQueueThreshold.dat";
+  std::string outDir = "";
+  uint32_t width = 2000;
+  double tStart = -1;
+  double tEnd = -1;
+  uint32_t nThreads = std::thread::hardware_concurrency ();
+  std::string gnuplot = "gnuplotScriptTotalPacketsInQueue";
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("dir", "The directory of the gnuplot scripts", dir);
+  cmd.AddValue ("queueDiscType", "The directory of the traces, in dir", queue_disc_type);
+  cmd.AddValue ("traces", "Comma separated traces to reduce, .bin ones are binary", traces);
+  cmd.AddValue ("outDir", "The directory of the reduced traces, default <dir>/<queueDiscType>/plot", outDir);
+  cmd.AddValue ("width", "Number of pixel columns of the plot", width);
+  cmd.AddValue ("tStart", "Start of the plotted time range in s, default the first sample", tStart);
+  cmd.AddValue ("tEnd", "End of the plotted time range in s, default the last sample", tEnd);
+  cmd.AddValue ("nThreads", "Number of chunks of a trace parsed at the same time, default one per core", nThreads);
+  cmd.AddValue ("gnuplot", "Comma separated gnuplot scripts in dir to run on outDir afterwards, none if empty", gnuplot);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (width == 0, "The width has to be positive");
+  if (nThreads == 0)
+    {
+      nThreads = 1;
+    }
+  if (outDir.empty ())
+    {
+      outDir = dir + queue_disc_type + "/plot";
+    }
+  std::string dirToSave = "mkdir -p " + outDir;
+  if (system (dirToSave.c_str ()) == -1)
+    {
+      exit (1);
+    }
+
+  for (const std::string &trace : Split (traces, ','))
+    {
+      std::string out = trace;
+      if (out.size () > 4 && out.compare (out.size () - 4, 4, ".bin") == 0)
+        {
+          out.replace (out.size () - 4, 4, ".dat");
+        }
+      uint64_t nPoints = 0;
+      uint64_t nSamples = ReduceTrace (dir + queue_disc_type + "/" + trace, outDir + "/" + out,
+                                       width, tStart, tEnd, nThreads, nPoints);
+      if (nSamples > 0)
+        {
+          std::cout << trace << ": " << nSamples << " samples, " << nPoints << " points" << std::endl;
+        }
+    }
+
   // command line needs to be in ./ns-3.36.1/scratch/ inorder for the script to produce gnuplot correctly///
-  // system (("gnuplot " + dir + "gnuplotScriptTcHighPriorityPacketsInQueue").c_str ());
-  // system (("gnuplot " + dir + "gnuplotScriptHighPriorityQueueThreshold").c_str ());
-  // system (("gnuplot " + dir + "gnuplotScriptHighPriority").c_str ());
-  // system (("gnuplot " + dir + "gnuplotScriptLowPriority").c_str ());
-  system (("gnuplot " + dir + "gnuplotScriptTotalPacketsInQueue").c_str ());
+  for (const std::string &script : Split (gnuplot, ','))
+    {
+      if (system (("gnuplot -e \"plotDir='" + outDir + "'\" " + dir + script).c_str ()) != 0)
+        {
+          std::cerr << "gnuplot " << script << " failed" << std::endl;
+        }
+    }
 
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,520 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COLUMNAR_RESULTS_H
+#define COLUMNAR_RESULTS_H
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+/**
+ * \brief A table of results stored by column.
+ *
+ * Every column holds 64 bit unsigned integers (counters, sizes, times in ns)
+ * or doubles. Rows are added at the end and filled with Set; a column added
+ * after some rows is zero in those rows, so a column per drop reason can be
+ * added when the reason is first seen.
+ */
+class ColumnarTable
+{
+public:
+  enum Type : uint8_t
+  {
+    UINT64 = 0,
+    DOUBLE = 1
+  };
+
+  explicit ColumnarTable (const std::string &name = "");
+
+  /**
+   * \param name the column name
+   * \param type the type of the values
+   * \return the index of the column, the existing one if the name is taken
+   */
+  uint32_t AddColumn (const std::string &name, Type type = UINT64);
+  /// add a row of zeros at the end
+  void AddRow (void);
+  /// set the value of a column in the last row
+  void Set (uint32_t column, uint64_t value);
+  void Set (uint32_t column, double value);
+  /// add the column if needed, then set its value in the last row
+  void Set (const std::string &name, uint64_t value);
+  void Set (const std::string &name, double value);
+
+  const std::string &GetName (void) const;
+  uint64_t GetNRows (void) const;
+  uint32_t GetNColumns (void) const;
+  /// \return the index of the column, -1 if there is none
+  int32_t FindColumn (const std::string &name) const;
+  const std::string &GetColumnName (uint32_t column) const;
+  Type GetColumnType (uint32_t column) const;
+  /// \return the value, converted to uint64 for a DOUBLE column
+  uint64_t GetUint (uint32_t column, uint64_t row) const;
+  /// \return the value, converted to double for a UINT64 column
+  double GetDouble (uint32_t column, uint64_t row) const;
+
+private:
+  friend class ColumnarResults;
+
+  struct Column
+  {
+    std::string name;
+    Type type;
+    std::vector<uint64_t> u;   //!< the values of a UINT64 column
+    std::vector<double> d;     //!< the values of a DOUBLE column
+  };
+
+  std::string m_name;
+  uint64_t m_nRows;
+  std::vector<Column> m_columns;
+};
+
+/**
+ * \brief A set of named ColumnarTable-s, written to and read from a compact
+ * binary file.
+ *
+ * The file is written in one pass at the end of a run, every column as one
+ * contiguous array, in host byte order:
+ *
+ *   "NS3COLS1", uint32 number of tables
+ *   per table:  uint32 name length, name, uint64 rows, uint32 columns,
+ *               per column: uint32 name length, name, uint8 type,
+ *               then the columns, rows * 8 bytes each, in column order
+ *
+ * Reading is a single read of the file, then a copy per column, so thousands
+ * of runs of a sweep can be loaded and aggregated without parsing text. The
+ * counts of the file are checked against its size before any allocation.
+ *
+ * Header only: every directory of scratch/ is built as one program, so the
+ * scenario directories share this copy through "../columnar-results.h".
+ */
+class ColumnarResults
+{
+public:
+  /// \return the table, added if there is none with that name
+  ColumnarTable &AddTable (const std::string &name);
+  /// \return the table, 0 if there is none with that name
+  const ColumnarTable *GetTable (const std::string &name) const;
+  uint32_t GetNTables (void) const;
+  const ColumnarTable &GetTable (uint32_t i) const;
+
+  /// write all tables to the file, aborts if it can not be written
+  void Write (const std::string &fileName) const;
+  /**
+   * Replace the tables by the ones of a file.
+   * \param fileName the file written by Write
+   * \return false if the file can not be read or is not a results file
+   */
+  bool Read (const std::string &fileName);
+
+private:
+  std::deque<ColumnarTable> m_tables;   //!< a deque keeps the references of AddTable valid
+};
+
+static const char COLUMNAR_MAGIC[8] = {'N', 'S', '3', 'C', 'O', 'L', 'S', '1'};
+
+inline
+ColumnarTable::ColumnarTable (const std::string &name)
+  : m_name (name),
+    m_nRows (0)
+{
+}
+
+inline uint32_t
+ColumnarTable::AddColumn (const std::string &name, Type type)
+{
+  int32_t existing = FindColumn (name);
+  if (existing >= 0)
+    {
+      NS_ABORT_MSG_IF (m_columns[existing].type != type, "Column " << name << " has another type");
+      return existing;
+    }
+  Column column;
+  column.name = name;
+  column.type = type;
+  if (type == UINT64)
+    {
+      column.u.assign (m_nRows, 0);
+    }
+  else
+    {
+      column.d.assign (m_nRows, 0);
+    }
+  m_columns.push_back (column);
+  return m_columns.size () - 1;
+}
+
+inline void
+ColumnarTable::AddRow (void)
+{
+  for (Column &column : m_columns)
+    {
+      if (column.type == UINT64)
+        {
+          column.u.push_back (0);
+        }
+      else
+        {
+          column.d.push_back (0);
+        }
+    }
+  m_nRows++;
+}
+
+inline void
+ColumnarTable::Set (uint32_t column, uint64_t value)
+{
+  NS_ABORT_MSG_IF (m_nRows == 0, "Add a row before setting values");
+  Column &c = m_columns.at (column);
+  if (c.type == UINT64)
+    {
+      c.u.back () = value;
+    }
+  else
+    {
+      c.d.back () = static_cast<double> (value);
+    }
+}
+
+inline void
+ColumnarTable::Set (uint32_t column, double value)
+{
+  NS_ABORT_MSG_IF (m_nRows == 0, "Add a row before setting values");
+  Column &c = m_columns.at (column);
+  if (c.type == DOUBLE)
+    {
+      c.d.back () = value;
+    }
+  else
+    {
+      c.u.back () = static_cast<uint64_t> (value);
+    }
+}
+
+inline void
+ColumnarTable::Set (const std::string &name, uint64_t value)
+{
+  Set (AddColumn (name, UINT64), value);
+}
+
+inline void
+ColumnarTable::Set (const std::string &name, double value)
+{
+  Set (AddColumn (name, DOUBLE), value);
+}
+
+inline const std::string &
+ColumnarTable::GetName (void) const
+{
+  return m_name;
+}
+
+inline uint64_t
+ColumnarTable::GetNRows (void) const
+{
+  return m_nRows;
+}
+
+inline uint32_t
+ColumnarTable::GetNColumns (void) const
+{
+  return m_columns.size ();
+}
+
+inline int32_t
+ColumnarTable::FindColumn (const std::string &name) const
+{
+  for (uint32_t i = 0; i < m_columns.size (); ++i)
+    {
+      if (m_columns[i].name == name)
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+inline const std::string &
+ColumnarTable::GetColumnName (uint32_t column) const
+{
+  return m_columns.at (column).name;
+}
+
+inline ColumnarTable::Type
+ColumnarTable::GetColumnType (uint32_t column) const
+{
+  return m_columns.at (column).type;
+}
+
+inline uint64_t
+ColumnarTable::GetUint (uint32_t column, uint64_t row) const
+{
+  const Column &c = m_columns.at (column);
+  return c.type == UINT64 ? c.u.at (row) : static_cast<uint64_t> (c.d.at (row));
+}
+
+inline double
+ColumnarTable::GetDouble (uint32_t column, uint64_t row) const
+{
+  const Column &c = m_columns.at (column);
+  return c.type == DOUBLE ? c.d.at (row) : static_cast<double> (c.u.at (row));
+}
+
+inline ColumnarTable &
+ColumnarResults::AddTable (const std::string &name)
+{
+  for (ColumnarTable &table : m_tables)
+    {
+      if (table.GetName () == name)
+        {
+          return table;
+        }
+    }
+  m_tables.push_back (ColumnarTable (name));
+  return m_tables.back ();
+}
+
+inline const ColumnarTable *
+ColumnarResults::GetTable (const std::string &name) const
+{
+  for (const ColumnarTable &table : m_tables)
+    {
+      if (table.GetName () == name)
+        {
+          return &table;
+        }
+    }
+  return 0;
+}
+
+inline uint32_t
+ColumnarResults::GetNTables (void) const
+{
+  return m_tables.size ();
+}
+
+inline const ColumnarTable &
+ColumnarResults::GetTable (uint32_t i) const
+{
+  return m_tables.at (i);
+}
+
+template <typename T>
+inline void
+ColumnarWriteValue (std::ostream &os, T value)
+{
+  os.write (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+inline void
+ColumnarWriteString (std::ostream &os, const std::string &s)
+{
+  ColumnarWriteValue<uint32_t> (os, s.size ());
+  os.write (s.data (), s.size ());
+}
+
+inline void
+ColumnarResults::Write (const std::string &fileName) const
+{
+  std::vector<char> buffer (1 << 20);
+  std::ofstream os;
+  // the buffer has to be installed before the file is opened
+  os.rdbuf ()->pubsetbuf (buffer.data (), buffer.size ());
+  os.open (fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_IF (!os, "Can not open " << fileName);
+
+  os.write (COLUMNAR_MAGIC, sizeof (COLUMNAR_MAGIC));
+  ColumnarWriteValue<uint32_t> (os, m_tables.size ());
+  for (const ColumnarTable &table : m_tables)
+    {
+      ColumnarWriteString (os, table.m_name);
+      ColumnarWriteValue<uint64_t> (os, table.m_nRows);
+      ColumnarWriteValue<uint32_t> (os, table.m_columns.size ());
+      for (const ColumnarTable::Column &column : table.m_columns)
+        {
+          ColumnarWriteString (os, column.name);
+          ColumnarWriteValue<uint8_t> (os, column.type);
+        }
+      for (const ColumnarTable::Column &column : table.m_columns)
+        {
+          const char *data = column.type == ColumnarTable::UINT64
+            ? reinterpret_cast<const char *> (column.u.data ())
+            : reinterpret_cast<const char *> (column.d.data ());
+          os.write (data, table.m_nRows * 8);
+        }
+    }
+  os.close ();
+  NS_ABORT_MSG_IF (!os, "Error writing " << fileName);
+}
+
+/// bounds checked reads from the contents of a results file
+class ColumnarReader
+{
+public:
+  ColumnarReader (const std::vector<char> &data)
+    : m_data (data),
+      m_pos (0),
+      m_ok (true)
+  {
+  }
+
+  bool
+  Read (void *out, uint64_t n)
+  {
+    if (!m_ok || n > m_data.size () - m_pos)
+      {
+        m_ok = false;
+        return false;
+      }
+    if (n == 0)
+      {
+        return true;
+      }
+    std::memcpy (out, m_data.data () + m_pos, n);
+    m_pos += n;
+    return true;
+  }
+
+  template <typename T>
+  T
+  ReadValue (void)
+  {
+    T value = 0;
+    Read (&value, sizeof (value));
+    return value;
+  }
+
+  std::string
+  ReadString (void)
+  {
+    uint32_t n = ReadValue<uint32_t> ();
+    if (!m_ok || n > m_data.size () - m_pos)
+      {
+        m_ok = false;
+        return "";
+      }
+    std::string s (m_data.data () + m_pos, n);
+    m_pos += n;
+    return s;
+  }
+
+  bool
+  IsOk (void) const
+  {
+    return m_ok;
+  }
+
+  /// \return the number of bytes left to read
+  uint64_t
+  GetRemaining (void) const
+  {
+    return m_data.size () - m_pos;
+  }
+
+private:
+  const std::vector<char> &m_data;
+  uint64_t m_pos;
+  bool m_ok;
+};
+
+inline bool
+ColumnarResults::Read (const std::string &fileName)
+{
+  std::ifstream is (fileName, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!is)
+    {
+      return false;
+    }
+  std::vector<char> data (static_cast<std::size_t> (is.tellg ()));
+  is.seekg (0);
+  if (!is.read (data.data (), data.size ()))
+    {
+      return false;
+    }
+
+  ColumnarReader reader (data);
+  char magic[sizeof (COLUMNAR_MAGIC)];
+  if (!reader.Read (magic, sizeof (magic)) || std::memcmp (magic, COLUMNAR_MAGIC, sizeof (magic)) != 0)
+    {
+      return false;
+    }
+  std::deque<ColumnarTable> tables;
+  uint32_t nTables = reader.ReadValue<uint32_t> ();
+  for (uint32_t t = 0; t < nTables && reader.IsOk (); ++t)
+    {
+      ColumnarTable table (reader.ReadString ());
+      table.m_nRows = reader.ReadValue<uint64_t> ();
+      uint32_t nColumns = reader.ReadValue<uint32_t> ();
+      // a column header takes at least 5 bytes, do not trust the counts of a
+      // truncated or corrupt file before allocating
+      if (!reader.IsOk () || nColumns > reader.GetRemaining () / 5)
+        {
+          return false;
+        }
+      table.m_columns.resize (nColumns);
+      for (ColumnarTable::Column &column : table.m_columns)
+        {
+          column.name = reader.ReadString ();
+          uint8_t type = reader.ReadValue<uint8_t> ();
+          if (!reader.IsOk () || type > ColumnarTable::DOUBLE)
+            {
+              return false;
+            }
+          column.type = static_cast<ColumnarTable::Type> (type);
+        }
+      // the columns need 8 bytes per row each
+      if (nColumns > 0 && table.m_nRows > reader.GetRemaining () / 8 / nColumns)
+        {
+          return false;
+        }
+      for (ColumnarTable::Column &column : table.m_columns)
+        {
+          if (column.type == ColumnarTable::UINT64)
+            {
+              column.u.resize (table.m_nRows);
+              reader.Read (column.u.data (), table.m_nRows * 8);
+            }
+          else
+            {
+              column.d.resize (table.m_nRows);
+              reader.Read (column.d.data (), table.m_nRows * 8);
+            }
+          if (!reader.IsOk ())
+            {
+              return false;
+            }
+        }
+      tables.push_back (table);
+    }
+  if (!reader.IsOk ())
+    {
+      return false;
+    }
+  m_tables.swap (tables);
+  return true;
+}
+
+} // namespace ns3
+
+#endif /* COLUMNAR_RESULTS_H */
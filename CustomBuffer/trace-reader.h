@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Reading of the "time value" queue traces written by the trace callbacks of
+// the scenarios, from a memory mapping of the whole file.
+// Header only, shared by the tools of CustomBuffer as "../trace-reader.h".
+
+namespace ns3 {
+
+// a read only mapping of a whole file
+class MappedFile
+{
+public:
+  explicit MappedFile (const std::string &fileName)
+    : m_data (0),
+      m_size (0)
+  {
+    int fd = open (fileName.c_str (), O_RDONLY);
+    if (fd < 0)
+      {
+        return;
+      }
+    struct stat st;
+    if (fstat (fd, &st) == 0 && st.st_size > 0)
+      {
+        void *p = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED)
+          {
+            madvise (p, st.st_size, MADV_SEQUENTIAL);
+            m_data = static_cast<const char *> (p);
+            m_size = st.st_size;
+          }
+      }
+    close (fd);
+  }
+
+  ~MappedFile ()
+  {
+    if (m_data)
+      {
+        munmap (const_cast<char *> (m_data), m_size);
+      }
+  }
+
+  const char *
+  GetData (void) const
+  {
+    return m_data;
+  }
+
+  std::size_t
+  GetSize (void) const
+  {
+    return m_size;
+  }
+
+private:
+  MappedFile (const MappedFile &);
+  MappedFile &operator= (const MappedFile &);
+
+  const char *m_data;
+  std::size_t m_size;
+};
+
+
+// parse a decimal number as written by an ostream ("1.00584", "2e-05"), the
+// mapping is not null terminated so strtod can not be used
+inline bool
+ParseNumber (const char *&p, const char *end, double &value)
+{
+  while (p < end && (*p == ' ' || *p == '\t'))
+    {
+      ++p;
+    }
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    {
+      negative = *p++ == '-';
+    }
+  uint64_t mantissa = 0;
+  int32_t exponent = 0;
+  bool digits = false;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p, digits = true)
+    {
+      if (mantissa < 100000000000000000ULL)
+        {
+          mantissa = mantissa * 10 + (*p - '0');
+        }
+      else
+        {
+          exponent++;
+        }
+    }
+  if (p < end && *p == '.')
+    {
+      for (++p; p < end && *p >= '0' && *p <= '9'; ++p, digits = true)
+        {
+          if (mantissa < 100000000000000000ULL)
+            {
+              mantissa = mantissa * 10 + (*p - '0');
+              exponent--;
+            }
+        }
+    }
+  if (!digits)
+    {
+      return false;
+    }
+  if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      const char *q = p + 1;
+      bool negativeExponent = false;
+      if (q < end && (*q == '-' || *q == '+'))
+        {
+          negativeExponent = *q++ == '-';
+        }
+      int32_t e = 0;
+      for (; q < end && *q >= '0' && *q <= '9'; ++q)
+        {
+          e = std::min (e * 10 + (*q - '0'), 10000);
+        }
+      exponent += negativeExponent ? -e : e;
+      p = q;
+    }
+  value = static_cast<double> (mantissa);
+  if (exponent > 0)
+    {
+      value *= std::pow (10.0, exponent);
+    }
+  else if (exponent < 0)
+    {
+      value /= std::pow (10.0, -exponent);
+    }
+  if (negative)
+    {
+      value = -value;
+    }
+  return true;
+}
+
+// parse the line starting at p, then move p to the start of the next line
+inline bool
+ParseLine (const char *&p, const char *end, double &t, double &v)
+{
+  bool ok = ParseNumber (p, end, t) && ParseNumber (p, end, v);
+  const char *eol = static_cast<const char *> (memchr (p, '\n', end - p));
+  p = eol ? eol + 1 : end;
+  return ok;
+}
+
+
+// the times of the first and the last sample of a text trace
+inline bool
+GetTextTimeRange (const MappedFile &file, double &tFirst, double &tLast)
+{
+  const char *data = file.GetData ();
+  const char *end = data + file.GetSize ();
+  double v;
+  bool found = false;
+  for (const char *p = data; p < end && !found;)
+    {
+      found = ParseLine (p, end, tFirst, v);
+    }
+  if (!found)
+    {
+      return false;
+    }
+  // the last line that parses, searching back from the end
+  while (end > data)
+    {
+      const char *begin = end - 1;
+      while (begin > data && begin[-1] != '\n')
+        {
+          --begin;
+        }
+      const char *p = begin;
+      if (ParseLine (p, end, tLast, v))
+        {
+          return true;
+        }
+      end = begin;
+    }
+  return false;
+}
+
+// reads the samples of a text trace in order, skipping the lines that do not parse
+class TraceCursor
+{
+public:
+  explicit TraceCursor (const MappedFile &file)
+    : m_p (file.GetData ()),
+      m_end (file.GetData () + file.GetSize ())
+  {
+  }
+
+  bool
+  Next (double &t, double &v)
+  {
+    while (m_p < m_end)
+      {
+        if (ParseLine (m_p, m_end, t, v))
+          {
+            return true;
+          }
+      }
+    return false;
+  }
+
+private:
+  const char *m_p;
+  const char *m_end;
+};
+
+} // namespace ns3
+
+#endif /* TRACE_READER_H */
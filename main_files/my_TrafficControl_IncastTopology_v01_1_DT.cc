@@ -27,7 +27,7 @@
 //               .  /                              .
 //               . / 10Mb/s, 10ms                  . 
 //               ./                                .
-//               n1                                .
+//               n(N-1)  (N = nSenders)            .
 //
 // - Tracing of queues and packet receptions to file 
 //   "tcp-large-transfer.tr"
@@ -35,10 +35,16 @@
 //   "tcp-large-transfer-$n-$i.pcap" where n and i represent node and interface
 // numbers respectively
 //  Usage (e.g.): ./ns3 run scratch/my_lineTopology_v01
+//  With an MPI enabled build the senders are spread over the ranks, the router
+//  and reciever run on rank 0 (e.g. mpirun -np 4 <binary> --nSenders=1000).
+//  Warm start: save the state after the warm-up once (--checkpointSave=warm.ckpt
+//  --checkpointTime=1.5), then run every variant from it (--checkpointLoad=warm.ckpt),
+//  see incast-checkpoint.h.
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <sstream>
 #include <numeric>
 
 #include "ns3/core-module.h"
@@ -53,6 +59,14 @@
 #include "ns3/flow-monitor-module.h"
 #include "tutorial-app.h"  
 #include "custom_onoff-application.h" 
+#include "sim-profiler.h"
+#include "incast-topology-helper.h"
+#include "flow-stats-collector.h"
+#include "incast-checkpoint.h"
+#include "results-tables.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#endif
 
 using namespace ns3;
 
@@ -120,17 +134,57 @@ int main (int argc, char *argv[])
   std::string transportProt = "Udp";
   std::string socketType;
   std::string queue_capacity;
+  std::string queueDiscSize = "100p"; // the root queue disc size, independent of the application type
+  uint32_t nSenders = 2;
+  std::string senderRate = "10Mbps";
+  std::string senderDelay = "5ms";
+  std::string bottleneckRate = "1Mbps";
+  std::string bottleneckDelay = "10ms";
+  uint64_t miceBytes = 100000;
+  std::string checkpointSave;
+  double checkpointTime = 1.5; //seconds
+  std::string checkpointLoad;
+  std::string results;
+
+  bool profile = false;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue("Simulation Time", "The total time for the simulation to run", simulationTime);
   cmd.AddValue ("applicationType", "Application type to use to send data: standardClient, customApplication, OnOff, customOnOff", applicationType);
   cmd.AddValue ("transportProt", "Transport protocol to use: Tcp, Udp", transportProt);
+  cmd.AddValue ("nSenders", "Number of senders in the incast", nSenders);
+  cmd.AddValue ("queueCapacity", "The root queue disc size B, e.g. 100p", queueDiscSize);
+  cmd.AddValue ("senderRate", "The data rate of the sender links", senderRate);
+  cmd.AddValue ("senderDelay", "The delay of the sender links", senderDelay);
+  cmd.AddValue ("bottleneckRate", "The data rate of the bottleneck link", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "The delay of the bottleneck link", bottleneckDelay);
+  cmd.AddValue ("miceBytes", "The largest flow [bytes] counted as mice in the FCT statistics", miceBytes);
+  cmd.AddValue ("checkpointSave", "Save the state at checkpointTime to this file and stop", checkpointSave);
+  cmd.AddValue ("checkpointTime", "The time of the checkpoint [s]", checkpointTime);
+  cmd.AddValue ("checkpointLoad", "Warm start from this checkpoint file, skipping the warm-up", checkpointLoad);
+  cmd.AddValue ("results", "Also write the per flow and queue disc statistics to this columnar binary file", results);
+  // the queue disc alphas and the mice threshold are attributes, e.g.
+  // --ns3::DT_FifoQueueDisc_v02::AlphaHigh=4 --CustomOnOffApplication::MiceThreshold=20
+  cmd.AddValue ("profile", "Print the events and packets per wall second and the queue disc hot path time", profile);
   cmd.Parse (argc, argv);
+
+  uint32_t systemId = 0;
+  uint32_t systemCount = 1;
+#ifdef NS3_MPI
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+  MpiInterface::Enable (&argc, &argv);
+  systemId = MpiInterface::GetSystemId ();
+  systemCount = MpiInterface::GetSize ();
+#endif
   
   // Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));
   // Config::SetDefault ("ns3::UdpSocket::InitialCwnd", UintegerValue (1));
   // Config::SetDefault ("ns3::TcpL4Protocol::RecoveryType", TypeIdValue (TypeId::LookupByName ("ns3::TcpClassicRecovery")));
 
+  bool checkpoint = !checkpointSave.empty () || !checkpointLoad.empty ();
+  NS_ABORT_MSG_IF (checkpoint && systemCount > 1, "Checkpoints need a single rank");
+  NS_ABORT_MSG_IF (checkpoint && transportProt.compare ("Tcp") == 0, "Checkpoints do not save the TCP socket state, use Udp");
+
   // Application type dependent parameters
   if (applicationType.compare("standardClient") == 0)
     {
@@ -171,97 +225,84 @@ int main (int argc, char *argv[])
   
   LogComponentEnable("PacketSink", LOG_LEVEL_INFO); 
 
-  // Here, we will explicitly create three nodes.  The first container contains
-  // nodes 0 and 1 from the diagram above, and the second one contains nodes
-  // 1 and 2.  This reflects the channel connectivity, and will be used to
-  // install the network interfaces and connect them with a channel.
-  NodeContainer clientNodes;
-  clientNodes.Create (3);
-
-  NodeContainer serverNodes;
-  serverNodes.Add (clientNodes.Get (1));
-  serverNodes.Create (1);
-
-  NodeContainer allNodes = NodeContainer (serverNodes, clientNodes.Get(0), clientNodes.Get(2));
-
-  // Install network stacks on the nodes
-  InternetStackHelper internet;
-  internet.Install (allNodes);
-
-  // We create the channels first without any IP addressing information
-  // First make and configure the helper, so that it will put the appropriate
-  // attributes on the network interfaces and channels we are about to install.
-  
-  // Create the point-to-point link helpers
-  PointToPointHelper p2p1_l;  // the link between each sender to Router
-  p2p1_l.SetDeviceAttribute  ("DataRate", StringValue ("10Mbps"));
-  p2p1_l.SetChannelAttribute ("Delay", StringValue ("5ms"));
-
-  PointToPointHelper p2p1_h;  // the link between each sender to Router
-  p2p1_h.SetDeviceAttribute  ("DataRate", StringValue ("10Mbps"));
-  p2p1_h.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  // N senders, each on its own link to the router R, and one bottleneck link
+  // from R to the reciever S (see the diagram above).
+  PointToPointHelper p2p1;  // the link between each sender to Router
+  p2p1.SetDeviceAttribute  ("DataRate", StringValue (senderRate));
+  p2p1.SetChannelAttribute ("Delay", StringValue (senderDelay));
 
   PointToPointHelper p2p2;  // the link between router and Reciever
-  p2p2.SetDeviceAttribute  ("DataRate", StringValue ("1Mbps"));
-  p2p2.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  p2p2.SetDeviceAttribute  ("DataRate", StringValue (bottleneckRate));
+  p2p2.SetChannelAttribute ("Delay", StringValue (bottleneckDelay));
   // minimal value for NetDevice buffer is 1p. we set it in order to observe Traffic Controll effects only.
   p2p2.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
 
-
-  // And then install devices and channels connecting our topology.
-  NetDeviceContainer sender1 = p2p1_l.Install (clientNodes.Get(0), clientNodes.Get(1));
-  NetDeviceContainer sender2 = p2p1_h.Install (clientNodes.Get(2), clientNodes.Get(1));
-  // NetDeviceContainer sender3 = p2p1.Install (senders.Get(3), senders.Get(1));
-  NetDeviceContainer reciever = p2p2.Install (serverNodes);
-
-
   TrafficControlHelper tch;
   // tch.SetRootQueueDisc ("ns3::RedQueueDisc", "MaxSize", StringValue ("10p"));
   // tch.SetRootQueueDisc ("ns3::PfifoFastQueueDisc", "MaxSize", StringValue ("10p"));
-  tch.SetRootQueueDisc ("ns3::DT_FifoQueueDisc_v02", "MaxSize", StringValue ("100p"));
-  
-  QueueDiscContainer qdiscs = tch.Install (reciever);
+  tch.SetRootQueueDisc ("ns3::DT_FifoQueueDisc_v02", "MaxSize", StringValue (queueDiscSize));
+
+  IncastTopologyHelper incast (nSenders, p2p1, p2p2);
+  incast.SetSystemCount (systemCount);
+  incast.Install (tch);
+  // every rank builds the whole topology, but only runs its own nodes
+  NodeContainer allNodes;
+  NodeContainer topologyNodes = incast.GetAllNodes ();
+  for (uint32_t i = 0; i < topologyNodes.GetN (); ++i)
+    {
+      if (topologyNodes.Get (i)->GetSystemId () == systemId)
+        {
+          allNodes.Add (topologyNodes.Get (i));
+        }
+    }
 
-  // Ptr<QueueDisc> q = qdiscs.Get (1); // original code - doesn't show values
-  Ptr<QueueDisc> q = qdiscs.Get (0); // look at the router queue - shows actual values
+  Ptr<QueueDisc> q = incast.GetSwitchQueueDisc (); // look at the router queue - shows actual values
   // The Next Line Displayes "PacketsInQueue" statistic at the Traffic Controll Layer
   // q->TraceConnectWithoutContext ("PacketsInQueue", MakeCallback (&TcPacketsInQueueTrace));
   q->TraceConnectWithoutContext ("HighPriorityPacketsInQueue", MakeCallback (&TcHighPriorityPacketsInQueueTrace));  // ### ADDED BY ME #####
   q->TraceConnectWithoutContext ("LowPriorityPacketsInQueue", MakeCallback (&TcLowPriorityPacketsInQueueTrace));  // ### ADDED BY ME #####
   q->TraceConnectWithoutContext("EnqueueingThreshold_High", MakeCallback (&QueueThresholdHighTrace)); // ### ADDED BY ME #####
   q->TraceConnectWithoutContext("EnqueueingThreshold_Low", MakeCallback (&QueueThresholdLowTrace)); // ### ADDED BY ME #####
-  Config::ConnectWithoutContextFailSafe ("/NodeList/1/$ns3::TrafficControlLayer/RootQueueDiscList/0/SojournTime",
-                                 MakeCallback (&SojournTimeTrace));
+  // per packet sojourn times, the per class histogram is printed at the end
+  // q->TraceConnectWithoutContext ("SojournTime", MakeCallback (&SojournTimeTrace));
 
-  // Ptr<NetDevice> nd = serverDevice.Get (1);  // original value
-  Ptr<NetDevice> nd = reciever.Get (0);  //router side? fits queue-discs-benchmark example
+  Ptr<NetDevice> nd = incast.GetBottleneckDevice ();  //router side? fits queue-discs-benchmark example
   Ptr<PointToPointNetDevice> ptpnd = DynamicCast<PointToPointNetDevice> (nd);
   Ptr<Queue<Packet> > queue = ptpnd->GetQueue ();
   // The Next Line Displayes "PacketsInQueue" statistic at the NetDevice Layer
   // queue->TraceConnectWithoutContext ("PacketsInQueue", MakeCallback (&DevicePacketsInQueueTrace));
 
-
-  // Assign IP addresses
-  Ipv4AddressHelper ipv4;
-  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
-  ipv4.NewNetwork ();
-  Ipv4InterfaceContainer sender1Interface = ipv4.Assign (sender1);
-  ipv4.NewNetwork ();
-  Ipv4InterfaceContainer sender2Interface = ipv4.Assign (sender2);
-  // ipv4.NewNetwork ();
-  // Ipv4InterfaceContainer sender3Interface = ipv4.Assign (sender3);
-  ipv4.NewNetwork ();
-  Ipv4InterfaceContainer routerInterface = ipv4.Assign (reciever);
-
-  // and setup ip routing tables to get total ip-level connectivity.
-  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
-
   uint16_t servPort = 50000;
   Address sinkLocalAddress (InetSocketAddress (Ipv4Address::GetAny (), servPort));
-  // Create a packet sink to receive these packets on n2
-  PacketSinkHelper sink (socketType, sinkLocalAddress);                       
-  ApplicationContainer sinkApp = sink.Install (serverNodes.Get (1));
+  // Create a packet sink to receive these packets on the reciever
+  PacketSinkHelper sink (socketType, sinkLocalAddress);
+  ApplicationContainer sinkApp;
+  if (incast.GetReceiver ()->GetSystemId () == systemId)
+    {
+      sinkApp = sink.Install (incast.GetReceiver ());
+    }
   sinkApp.Start (Seconds (0.0));
+
+  // a warm start runs from the checkpoint, the parameters fixing the state
+  // at the checkpoint must be the same as in the run that saved it
+  IncastCheckpoint incastCheckpoint;
+  std::ostringstream scenario;
+  scenario << "nSenders=" << nSenders << " applicationType=" << applicationType
+           << " transportProt=" << transportProt << " senderRate=" << senderRate
+           << " senderDelay=" << senderDelay << " bottleneckRate=" << bottleneckRate
+           << " bottleneckDelay=" << bottleneckDelay;
+  incastCheckpoint.SetScenario (scenario.str ());
+  incastCheckpoint.SetQueueDisc (q);
+  if (sinkApp.GetN () > 0)
+    {
+      incastCheckpoint.SetSink (DynamicCast<PacketSink> (sinkApp.Get (0)));
+    }
+  Time appStartTime = Seconds (1.0);
+  if (!checkpointLoad.empty ())
+    {
+      appStartTime = Max (appStartTime, incastCheckpoint.Load (checkpointLoad));
+      std::cout << "Warm start from " << checkpointLoad << " at " << appStartTime.GetSeconds () << " s" << std::endl;
+    }
   sinkApp.Stop (Seconds (simulationTime + 0.1));
   
   uint32_t longPayloadSize = 1024;
@@ -271,172 +312,157 @@ int main (int argc, char *argv[])
 
   // Install application on the senders
   //get the address of the reciever node NOT THE ROUTER!!!
-  if (applicationType.compare("standardClient") == 0)
-  {
-    UdpClientHelper udpClientShort (routerInterface.GetAddress(1), servPort);
-    udpClientShort.SetAttribute ("Interval", TimeValue (Seconds (0.1)));
-    udpClientShort.SetAttribute ("PacketSize", UintegerValue (shortPayloadSize));
-    UdpClientHelper udpClientLong (routerInterface.GetAddress(1), servPort);
-    udpClientLong.SetAttribute ("Interval", TimeValue (Seconds (0.1)));
-    udpClientLong.SetAttribute ("PacketSize", UintegerValue (longPayloadSize));
-
-    ApplicationContainer sourceApps1 = udpClientShort.Install (clientNodes.Get (0));
-    sourceApps1.Start (Seconds (1.0));
-    sourceApps1.Stop (Seconds(3.0));
-    ApplicationContainer sourceApps2 = udpClientLong.Install (clientNodes.Get (2));
-    sourceApps2.Start (Seconds (1.0));
-    sourceApps2.Stop (Seconds(3.0));
-    // ApplicationContainer sourceApps3 = udpClientLong.Install (clientNodes.Get (3));
-    // sourceApps3.Start (Seconds (1.0));
-    // sourceApps3.Stop (Seconds(3.0));
-  }
-  else if (applicationType.compare("OnOff") == 0)
-  {
-   // Create the OnOff applications to send TCP/UDP to the server
-    InetSocketAddress socketAddressUp = InetSocketAddress (routerInterface.GetAddress(1), servPort);
-    
-    OnOffHelper clientShortHelper (socketType, Address ());
-    OnOffHelper clientLongHelper (socketType, Address ());
-    
-    clientShortHelper.SetAttribute ("Remote", AddressValue (socketAddressUp));
-    clientShortHelper.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
-    clientShortHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
-    clientShortHelper.SetAttribute ("PacketSize", UintegerValue (shortPayloadSize));
-    clientShortHelper.SetAttribute ("DataRate", StringValue ("1Mb/s"));
-
-    clientLongHelper.SetAttribute ("Remote", AddressValue (socketAddressUp));
-    clientLongHelper.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
-    clientLongHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
-    clientLongHelper.SetAttribute ("PacketSize", UintegerValue (longPayloadSize));
-    clientLongHelper.SetAttribute ("DataRate", StringValue ("1Mb/s"));
-    
-  
-    ApplicationContainer sourceApps1 = clientShortHelper.Install (clientNodes.Get (0));
-    sourceApps1.Start (Seconds (1.0));
-    sourceApps1.Stop (Seconds(3.0));
-    ApplicationContainer sourceApps2 = clientLongHelper.Install (clientNodes.Get (2));
-    sourceApps2.Start (Seconds (1.0));
-    sourceApps2.Stop (Seconds(3.0));
-    // ApplicationContainer sourceApps3 = clientLongHelper.Install (clientNodes.Get (3));
-    // sourceApps3.Start (Seconds (1.0));
-    // sourceApps3.Stop (Seconds(3.0));
-  }
-  else if (applicationType.compare("customOnOff") == 0)
-  {
-    // Create the Custom application to send TCP/UDP to the server
-    Ptr<Socket> ns3UdpSocket1 = Socket::CreateSocket (clientNodes.Get (0), UdpSocketFactory::GetTypeId ());
-    Ptr<Socket> ns3UdpSocket2 = Socket::CreateSocket (clientNodes.Get (2), UdpSocketFactory::GetTypeId ());
-    // ns3UdpSocket->TraceConnectWithoutContext ("CongestionWindow", MakeCallback (&CwndChange));
-    
-    InetSocketAddress socketAddressUp = InetSocketAddress (routerInterface.GetAddress(1), servPort);
-    
-    Ptr<CustomOnOffApplication> customOnOffApp1 = CreateObject<CustomOnOffApplication> ();
-    customOnOffApp1->Setup(ns3UdpSocket1);
-    customOnOffApp1->SetAttribute("Remote", AddressValue (socketAddressUp));
-    customOnOffApp1->SetAttribute("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.2]"));
-    customOnOffApp1->SetAttribute("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.1]"));
-    customOnOffApp1->SetAttribute("PacketSize", UintegerValue (payloadSize));
-    customOnOffApp1->SetAttribute("DataRate", StringValue ("2Mb/s"));
-    customOnOffApp1->SetStartTime (Seconds (1.0));
-    customOnOffApp1->SetStopTime (Seconds(3.0));
-    clientNodes.Get (0)->AddApplication (customOnOffApp1);
-
-    Ptr<CustomOnOffApplication> customOnOffApp2 = CreateObject<CustomOnOffApplication> ();
-    customOnOffApp2->Setup(ns3UdpSocket2);
-    customOnOffApp2->SetAttribute("Remote", AddressValue (socketAddressUp));
-    customOnOffApp2->SetAttribute("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.2]"));
-    customOnOffApp2->SetAttribute("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.1]"));
-    customOnOffApp2->SetAttribute("PacketSize", UintegerValue (payloadSize));
-    customOnOffApp2->SetAttribute("DataRate", StringValue ("2Mb/s"));
-    customOnOffApp2->SetStartTime (Seconds (1.0));
-    customOnOffApp2->SetStopTime (Seconds(3.0));
-    clientNodes.Get (2)->AddApplication (customOnOffApp2);
-  }
-  else if (applicationType.compare("customApplication") == 0)
-  {
-    // Create the Custom application to send TCP/UDP to the server
-    Ptr<Socket> ns3UdpSocket1 = Socket::CreateSocket (clientNodes.Get (0), UdpSocketFactory::GetTypeId ());
-    Ptr<Socket> ns3UdpSocket2 = Socket::CreateSocket (clientNodes.Get (2), UdpSocketFactory::GetTypeId ());
-    // ns3UdpSocket->TraceConnectWithoutContext ("CongestionWindow", MakeCallback (&CwndChange));
-    
-    InetSocketAddress socketAddressUp = InetSocketAddress (routerInterface.GetAddress(1), servPort);
-
-    Ptr<TutorialApp> customApp1 = CreateObject<TutorialApp> ();
-    customApp1->Setup (ns3UdpSocket1, socketAddressUp, payloadSize, numOfPackets, DataRate ("1Mbps"));
-    clientNodes.Get (0)->AddApplication (customApp1);
-    customApp1->SetStartTime (Seconds (1.0));
-    customApp1->SetStopTime (Seconds(3.0));
-
-    Ptr<TutorialApp> customApp2 = CreateObject<TutorialApp> ();
-    customApp2->Setup (ns3UdpSocket2, socketAddressUp, payloadSize, numOfPackets, DataRate ("1Mbps"));
-    clientNodes.Get (2)->AddApplication (customApp2);
-    customApp2->SetStartTime (Seconds (1.0));
-    customApp2->SetStopTime (Seconds(3.0));
-  }
+  InetSocketAddress socketAddressUp = InetSocketAddress (incast.GetReceiverAddress (), servPort);
+
+  UdpClientHelper udpClientShort (incast.GetReceiverAddress (), servPort);
+  udpClientShort.SetAttribute ("Interval", TimeValue (Seconds (0.1)));
+  udpClientShort.SetAttribute ("PacketSize", UintegerValue (shortPayloadSize));
+  UdpClientHelper udpClientLong (incast.GetReceiverAddress (), servPort);
+  udpClientLong.SetAttribute ("Interval", TimeValue (Seconds (0.1)));
+  udpClientLong.SetAttribute ("PacketSize", UintegerValue (longPayloadSize));
+
+  OnOffHelper clientShortHelper (socketType, Address ());
+  clientShortHelper.SetAttribute ("Remote", AddressValue (socketAddressUp));
+  clientShortHelper.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+  clientShortHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+  clientShortHelper.SetAttribute ("PacketSize", UintegerValue (shortPayloadSize));
+  clientShortHelper.SetAttribute ("DataRate", StringValue ("1Mb/s"));
+
+  OnOffHelper clientLongHelper (socketType, Address ());
+  clientLongHelper.SetAttribute ("Remote", AddressValue (socketAddressUp));
+  clientLongHelper.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+  clientLongHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+  clientLongHelper.SetAttribute ("PacketSize", UintegerValue (longPayloadSize));
+  clientLongHelper.SetAttribute ("DataRate", StringValue ("1Mb/s"));
+
+  // even senders send the short packets, odd senders the long ones
+  for (uint32_t i = 0; i < incast.GetNSenders (); ++i)
+    {
+      Ptr<Node> sender = incast.GetSender (i);
+      if (sender->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      bool shortSender = (i % 2 == 0);
+      ApplicationContainer sourceApps;
+      if (applicationType.compare("standardClient") == 0)
+        {
+          sourceApps = shortSender ? udpClientShort.Install (sender) : udpClientLong.Install (sender);
+        }
+      else if (applicationType.compare("OnOff") == 0)
+        {
+          sourceApps = shortSender ? clientShortHelper.Install (sender) : clientLongHelper.Install (sender);
+        }
+      else if (applicationType.compare("customOnOff") == 0)
+        {
+          // Create the Custom application to send TCP/UDP to the server
+          Ptr<Socket> ns3UdpSocket = Socket::CreateSocket (sender, UdpSocketFactory::GetTypeId ());
+          Ptr<CustomOnOffApplication> customOnOffApp = CreateObject<CustomOnOffApplication> ();
+          customOnOffApp->Setup(ns3UdpSocket);
+          customOnOffApp->SetAttribute("Remote", AddressValue (socketAddressUp));
+          customOnOffApp->SetAttribute("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.2]"));
+          customOnOffApp->SetAttribute("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.1]"));
+          customOnOffApp->SetAttribute("PacketSize", UintegerValue (payloadSize));
+          customOnOffApp->SetAttribute("DataRate", StringValue ("2Mb/s"));
+          sender->AddApplication (customOnOffApp);
+          sourceApps.Add (customOnOffApp);
+        }
+      else if (applicationType.compare("customApplication") == 0)
+        {
+          // Create the Custom application to send TCP/UDP to the server
+          Ptr<Socket> ns3UdpSocket = Socket::CreateSocket (sender, UdpSocketFactory::GetTypeId ());
+          Ptr<TutorialApp> customApp = CreateObject<TutorialApp> ();
+          customApp->Setup (ns3UdpSocket, socketAddressUp, payloadSize, numOfPackets, DataRate ("1Mbps"));
+          sender->AddApplication (customApp);
+          sourceApps.Add (customApp);
+        }
+      incastCheckpoint.AddApplication (sourceApps.GetN () > 0 ? sourceApps.Get (0) : nullptr);
+      sourceApps.Start (appStartTime);
+      sourceApps.Stop (Seconds(3.0));
+    }
 
   NS_LOG_INFO ("Run Simulation.");
   FlowMonitorHelper flowmon;
   Ptr<FlowMonitor> monitor = flowmon.Install(allNodes);
 
+  // per class FCT, one-way delay and goodput percentiles
+  FlowStatsCollector fctStats;
+  fctStats.SetMiceBytes (miceBytes);
+  NodeContainer localSenders;
+  for (uint32_t i = 0; i < incast.GetNSenders (); ++i)
+    {
+      if (incast.GetSender (i)->GetSystemId () == systemId)
+        {
+          localSenders.Add (incast.GetSender (i));
+        }
+    }
+  fctStats.InstallSenders (localSenders);
+  fctStats.AddReceiverAddress (incast.GetReceiverAddress ());
+  if (incast.GetReceiver ()->GetSystemId () == systemId)
+    {
+      fctStats.InstallReceivers (NodeContainer (incast.GetReceiver ()));
+    }
+
   Simulator::Stop (Seconds (simulationTime + 10));
+  if (!checkpointSave.empty ())
+    {
+      incastCheckpoint.ScheduleSave (checkpointSave, Seconds (checkpointTime));
+    }
+  if (!checkpointLoad.empty ())
+    {
+      incastCheckpoint.ScheduleRestore ();
+    }
+  if (profile)
+    {
+      // the summary is printed by Simulator::Destroy
+      SimProfiler::Get ().Enable ();
+    }
   Simulator::Run ();
 
   // monitor->SerializeToXmlFile("myTrafficControl_IncastTopology_v01_1.xml", true, true);
 
   Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
-  std::map<FlowId, FlowMonitor::FlowStats> stats = monitor->GetFlowStats ();
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
   std::cout << std::endl << "*** Flow monitor statistics ***" << std::endl;
-// a loop to sum the Tx/Rx Packets/Bytes from all nodes
+  if (systemCount > 1)
+    {
+      // a flow that crosses ranks is split between the sending and the receiving rank
+      std::cout << "  (rank " << systemId << " of " << systemCount << ", local nodes only)" << std::endl;
+    }
+// a loop to sum the Tx/Rx Packets and the drops from all flows
   uint32_t txPackets = 0; 
   uint64_t txBytes = 0;
   uint32_t rxPackets = 0; 
   uint64_t rxBytes = 0;
-  for (size_t i = 1; i <= stats.size(); i++)
+  uint32_t packetsDroppedByQueueDisc = 0;
+  uint64_t bytesDroppedByQueueDisc = 0;
+  uint32_t packetsDroppedByNetDevice = 0;
+  uint64_t bytesDroppedByNetDevice = 0;
+  for (const auto &flow : stats)
   {
-    txPackets = txPackets + stats[i].txPackets;
-    txBytes = txBytes + stats[i].txBytes;
-    rxPackets = rxPackets + stats[i].rxPackets;
-    rxBytes = rxBytes + stats[i].rxBytes;
+    const FlowMonitor::FlowStats &st = flow.second;
+    txPackets = txPackets + st.txPackets;
+    txBytes = txBytes + st.txBytes;
+    rxPackets = rxPackets + st.rxPackets;
+    rxBytes = rxBytes + st.rxBytes;
+    if (st.packetsDropped.size () > Ipv4FlowProbe::DROP_QUEUE_DISC)
+      {
+        packetsDroppedByQueueDisc = packetsDroppedByQueueDisc + st.packetsDropped[Ipv4FlowProbe::DROP_QUEUE_DISC];
+        bytesDroppedByQueueDisc = bytesDroppedByQueueDisc + st.bytesDropped[Ipv4FlowProbe::DROP_QUEUE_DISC];
+      }
+    if (st.packetsDropped.size () > Ipv4FlowProbe::DROP_QUEUE)
+      {
+        packetsDroppedByNetDevice = packetsDroppedByNetDevice + st.packetsDropped[Ipv4FlowProbe::DROP_QUEUE];
+        bytesDroppedByNetDevice = bytesDroppedByNetDevice + st.bytesDropped[Ipv4FlowProbe::DROP_QUEUE];
+      }
   }
 
   std::cout << "  Tx Packets/Bytes:   " << txPackets
             << " / " << txBytes << std::endl;
-  // std::cout << "  Tx Packets/Bytes:   " << stats[1].txPackets
-  //           << " / " << stats[1].txBytes << std::endl;
-  // std::cout << "  Offered Load: " << stats[1].txBytes * 8.0 / (stats[1].timeLastTxPacket.GetSeconds () - stats[1].timeFirstTxPacket.GetSeconds ()) / 1000000 << " Mbps" << std::endl;
   std::cout << "  Rx Packets/Bytes:   " << rxPackets
             << " / " << rxBytes << std::endl;
-  // std::cout << "  Rx Packets/Bytes:   " << stats[1].rxPackets
-  //           << " / " << stats[1].rxBytes << std::endl;
-
-  uint32_t packetsDroppedByQueueDisc = 0;
-  uint64_t bytesDroppedByQueueDisc = 0;
-  if (stats[1].packetsDropped.size () > Ipv4FlowProbe::DROP_QUEUE_DISC)
-    {
-      packetsDroppedByQueueDisc = stats[1].packetsDropped[Ipv4FlowProbe::DROP_QUEUE_DISC];
-      bytesDroppedByQueueDisc = stats[1].bytesDropped[Ipv4FlowProbe::DROP_QUEUE_DISC];
-    }
-  // add packets/bytes count from the other node
-  if (stats[2].packetsDropped.size () > Ipv4FlowProbe::DROP_QUEUE_DISC)
-    {
-      packetsDroppedByQueueDisc = packetsDroppedByQueueDisc + stats[2].packetsDropped[Ipv4FlowProbe::DROP_QUEUE_DISC];
-      bytesDroppedByQueueDisc = bytesDroppedByQueueDisc + stats[2].bytesDropped[Ipv4FlowProbe::DROP_QUEUE_DISC];
-    }  
   std::cout << "  Packets/Bytes Dropped by Queue Disc:   " << packetsDroppedByQueueDisc
             << " / " << bytesDroppedByQueueDisc << std::endl;
-  uint32_t packetsDroppedByNetDevice = 0;
-  uint64_t bytesDroppedByNetDevice = 0;
-  if (stats[1].packetsDropped.size () > Ipv4FlowProbe::DROP_QUEUE)
-    {
-      packetsDroppedByNetDevice = stats[1].packetsDropped[Ipv4FlowProbe::DROP_QUEUE];
-      bytesDroppedByNetDevice = stats[1].bytesDropped[Ipv4FlowProbe::DROP_QUEUE];
-    }
-  // add packets/bytes count from the other node  
-  if (stats[2].packetsDropped.size () > Ipv4FlowProbe::DROP_QUEUE)
-    {
-      packetsDroppedByNetDevice = packetsDroppedByNetDevice + stats[2].packetsDropped[Ipv4FlowProbe::DROP_QUEUE];
-      bytesDroppedByNetDevice = bytesDroppedByNetDevice + stats[2].bytesDropped[Ipv4FlowProbe::DROP_QUEUE];
-    }  
   std::cout << "  Packets/Bytes Dropped by NetDevice:   " << packetsDroppedByNetDevice
             << " / " << bytesDroppedByNetDevice << std::endl;
   // std::cout << "  Throughput: " << stats[1].rxBytes * 8.0 / (stats[1].timeLastRxPacket.GetSeconds () - stats[1].timeFirstRxPacket.GetSeconds ()) / 1000000 << " Mbps" << std::endl;
@@ -449,16 +475,43 @@ int main (int argc, char *argv[])
                 << "  count:   "<< p.second << std::endl;
     }
 
+  // the delays are measured on the reciever rank, the FCTs on the rank of the flow monitor
+  std::cout << std::endl << "*** Flow completion and delay statistics ***" << std::endl;
+  fctStats.AddFlowStats (stats, classifier);
+  fctStats.Print (std::cout);
+
   // Simulator::Destroy ();
 
-  std::cout << std::endl << "*** Application statistics ***" << std::endl;
-  double thr = 0;
-  uint64_t totalPacketsThr = DynamicCast<PacketSink> (sinkApp.Get (0))->GetTotalRx ();
-  thr = totalPacketsThr * 8 / (simulationTime * 1000000.0); //Mbit/s
-  std::cout << "  Rx Bytes: " << totalPacketsThr << std::endl;
-  std::cout << "  Average Goodput: " << thr << " Mbit/s" << std::endl;
-  std::cout << std::endl << "*** TC Layer statistics ***" << std::endl;
-  std::cout << q->GetStats () << std::endl;
-  return 0;
+  // the reciever and the router are on rank 0
+  if (systemId == 0)
+  {
+    std::cout << std::endl << "*** Application statistics ***" << std::endl;
+    double thr = 0;
+    // with a warm start, the bytes received before the checkpoint are counted too
+    uint64_t totalPacketsThr = DynamicCast<PacketSink> (sinkApp.Get (0))->GetTotalRx ()
+                               + incastCheckpoint.GetSinkRxBefore ();
+    thr = totalPacketsThr * 8 / (simulationTime * 1000000.0); //Mbit/s
+    std::cout << "  Rx Bytes: " << totalPacketsThr << std::endl;
+    std::cout << "  Average Goodput: " << thr << " Mbit/s" << std::endl;
+    std::cout << std::endl << "*** TC Layer statistics ***" << std::endl;
+    std::cout << q->GetStats () << std::endl;
+    q->GetStats ().PrintSojournHistograms (std::cout);
+  }
+
+  // the same statistics in one file per run for the results tool, one per rank with MPI
+  if (!results.empty ())
+    {
+      ColumnarResults tables;
+      AddFlowTable (tables, stats, classifier, miceBytes);
+      if (systemId == 0)
+        {
+          AddQueueDiscRow (tables, 0, q->GetStats ());
+        }
+      tables.Write (systemCount > 1 ? results + "." + std::to_string (systemId) : results);
+    }
   Simulator::Destroy ();
+#ifdef NS3_MPI
+  MpiInterface::Disable ();
+#endif
+  return 0;
 }
\ No newline at end of file
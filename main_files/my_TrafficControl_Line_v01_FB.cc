@@ -43,6 +43,7 @@
 #include "ns3/flow-monitor-module.h"
 #include "tutorial-app.h"
 #include "custom_onoff-application.h"
+#include "sim-profiler.h"
 
 
 using namespace ns3;
@@ -110,11 +111,23 @@ int main (int argc, char *argv[])
   std::string transportProt = "Udp";
   std::string socketType;
   std::string queue_capacity;
+  std::string senderRate = "10Mbps";
+  std::string senderDelay = "5ms";
+  std::string bottleneckRate = "100Kbps";
+  std::string bottleneckDelay = "10ms";
+
+  bool profile = false;
 
   CommandLine cmd (__FILE__);
   cmd.AddValue("Simulation Time", "The total time for the simulation to run", simulationTime);
   cmd.AddValue ("applicationType", "Application type to use to send data: OnOff, standardClient", applicationType);
   cmd.AddValue ("transportProt", "Transport protocol to use: Tcp, Udp", transportProt);
+  cmd.AddValue ("queueCapacity", "The queue disc size B, e.g. 100p, default depends on the application type", queue_capacity);
+  cmd.AddValue ("senderRate", "The data rate of the sender link", senderRate);
+  cmd.AddValue ("senderDelay", "The delay of the sender link", senderDelay);
+  cmd.AddValue ("bottleneckRate", "The data rate of the bottleneck link", bottleneckRate);
+  cmd.AddValue ("bottleneckDelay", "The delay of the bottleneck link", bottleneckDelay);
+  cmd.AddValue ("profile", "Print the events and packets per wall second and the queue disc hot path time", profile);
   cmd.Parse (argc, argv);
   
   // Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));
@@ -122,7 +135,11 @@ int main (int argc, char *argv[])
   // Config::SetDefault ("ns3::TcpL4Protocol::RecoveryType", TypeIdValue (TypeId::LookupByName ("ns3::TcpClassicRecovery")));
 
   // Application type dependent parameters
-  if (applicationType.compare("standardClient") == 0)
+  if (!queue_capacity.empty ())
+    {
+      // set on the command line
+    }
+  else if (applicationType.compare("standardClient") == 0)
     {
       queue_capacity = "20p"; // B, the total space on the buffer
     }
@@ -179,13 +196,13 @@ int main (int argc, char *argv[])
   
   // Create the point-to-point link helpers
   PointToPointHelper p2p1;  // the link from sender to Router
-  p2p1.SetDeviceAttribute  ("DataRate", StringValue ("10Mbps"));
-  p2p1.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  p2p1.SetDeviceAttribute  ("DataRate", StringValue (senderRate));
+  p2p1.SetChannelAttribute ("Delay", StringValue (senderDelay));
   // p2p1.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
 
   PointToPointHelper p2p2;  // the link between router and Reciever
-  p2p2.SetDeviceAttribute  ("DataRate", StringValue ("100Kbps"));
-  p2p2.SetChannelAttribute ("Delay", StringValue ("10ms"));
+  p2p2.SetDeviceAttribute  ("DataRate", StringValue (bottleneckRate));
+  p2p2.SetChannelAttribute ("Delay", StringValue (bottleneckDelay));
   // min value for NetDevice buffer is 1p. we set it in order to observe Traffic Controll effects only.
   p2p2.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("1p"));
 
@@ -212,8 +229,9 @@ int main (int argc, char *argv[])
   q->TraceConnectWithoutContext ("LowPriorityPacketsInQueue", MakeCallback (&TcLowPriorityPacketsInQueueTrace));  // ### ADDED BY ME #####
   q->TraceConnectWithoutContext("EnqueueingThreshold_High", MakeCallback (&QueueThresholdHighTrace)); // ### ADDED BY ME #####
   q->TraceConnectWithoutContext("EnqueueingThreshold_Low", MakeCallback (&QueueThresholdLowTrace)); // ### ADDED BY ME #####
-  Config::ConnectWithoutContextFailSafe ("/NodeList/1/$ns3::TrafficControlLayer/RootQueueDiscList/0/SojournTime",
-                                 MakeCallback (&SojournTimeTrace));                          
+  // per packet sojourn times, the per class histogram is printed at the end
+  // Config::ConnectWithoutContextFailSafe ("/NodeList/1/$ns3::TrafficControlLayer/RootQueueDiscList/0/SojournTime",
+  //                                MakeCallback (&SojournTimeTrace));                          
 
   // Ptr<NetDevice> nd = dev1.Get (1);  // original value
   Ptr<NetDevice> nd = dev1.Get (0);  //router side? fits queue-discs-benchmark example
@@ -307,6 +325,11 @@ int main (int argc, char *argv[])
   Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
   Simulator::Stop (Seconds (simulationTime + 10));
+  if (profile)
+    {
+      // the summary is printed by Simulator::Destroy
+      SimProfiler::Get ().Enable ();
+    }
   Simulator::Run ();
 
   Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
@@ -356,6 +379,7 @@ int main (int argc, char *argv[])
   std::cout << "  Average Goodput: " << thr << " Mbit/s" << std::endl;
   std::cout << std::endl << "*** TC Layer statistics ***" << std::endl;
   std::cout << q->GetStats () << std::endl;
-  return 0;
+  q->GetStats ().PrintSojournHistograms (std::cout);
   Simulator::Destroy ();
+  return 0;
 }
\ No newline at end of file
@@ -15,6 +15,8 @@
  *
  */
 
+#include <memory>
+
 #include "ns3/core-module.h"
 #include "ns3/network-module.h"
 #include "ns3/netanim-module.h"
@@ -22,6 +24,7 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/point-to-point-layout-module.h"
+#include "ring-pcap-capture.h"
 
 // Network topology (default)
 //
@@ -58,9 +61,26 @@ main (int argc, char *argv[])
   //uint32_t nSpokes = 8;
   uint32_t nSpokes = 2;
 
+  // "all": full pcap of every device, "ring": snaplen-limited ring on the
+  // bottleneck device written around drop bursts (ring-pcap-capture.h), "none"
+  std::string capture = "all";
+  uint32_t snapLen = 96;
+  uint32_t ringPackets = 4096;
+  uint32_t dropBurst = 10;
+  double dropWindow = 0.01;
+  double postTrigger = 0.1;
+
   CommandLine cmd (__FILE__);
   cmd.AddValue ("nSpokes", "Number of nodes to place in the star", nSpokes);
+  cmd.AddValue ("capture", "Packet capture: all, ring, none", capture);
+  cmd.AddValue ("snapLen", "Bytes kept per packet by the ring capture", snapLen);
+  cmd.AddValue ("ringPackets", "Packets kept in memory by the ring capture", ringPackets);
+  cmd.AddValue ("dropBurst", "Drops that trigger the ring capture, 0 for never", dropBurst);
+  cmd.AddValue ("dropWindow", "Time window of a drop burst [s]", dropWindow);
+  cmd.AddValue ("postTrigger", "Capture time after the last trigger [s]", postTrigger);
   cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (capture != "all" && capture != "ring" && capture != "none",
+                   "Unknown capture " << capture);
 
   NS_LOG_INFO ("Build star topology.");
   PointToPointHelper pointToPoint;
@@ -122,10 +142,26 @@ main (int argc, char *argv[])
   //
   // Do pcap tracing on all point-to-point devices on all nodes.
   //
-  pointToPoint.EnablePcapAll ("star");
+  if (capture == "all")
+    {
+      pointToPoint.EnablePcapAll ("star");
+    }
+  std::unique_ptr<RingPcapCapture> ring;
+  if (capture == "ring")
+    {
+      ring.reset (new RingPcapCapture ("star-ring", snapLen, ringPackets));
+      ring->SetDropBurst (dropBurst, Seconds (dropWindow));
+      ring->SetPostTrigger (Seconds (postTrigger));
+      // the spokes send to the hub, capture where the queue of spoke 0 builds
+      ring->Install (star.GetSpokeNode (0)->GetDevice (1));
+    }
 
   NS_LOG_INFO ("Run Simulation.");
   Simulator::Run ();
+  if (ring)
+    {
+      std::cout << "Ring capture: " << ring->GetIncidents () << " incident(s) written" << std::endl;
+    }
   Simulator::Destroy ();
   NS_LOG_INFO ("Done.");
 
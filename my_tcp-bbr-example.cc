@@ -61,6 +61,8 @@
 #include "ns3/traffic-control-module.h"
 #include "ns3/flow-monitor-module.h"
 
+#include "periodic-sampler.h"
+
 using namespace ns3;
 
 std::string dir;
@@ -69,26 +71,21 @@ Time prevTime = Seconds (0);
 
 // Calculate throughput
 static void
-TraceThroughput (Ptr<FlowMonitor> monitor)
+TraceThroughput (Ptr<FlowMonitor> monitor, std::ostream &thr)
 {
-  FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
   auto itr = stats.begin ();
   Time curTime = Now ();
-  std::ofstream thr (dir + "/throughput.dat", std::ios::out | std::ios::app);
-  thr <<  curTime << " " << 8 * (itr->second.txBytes - prev) / (1000 * 1000 * (curTime.GetSeconds () - prevTime.GetSeconds ())) << std::endl;
+  thr <<  curTime << " " << 8 * (itr->second.txBytes - prev) / (1000 * 1000 * (curTime.GetSeconds () - prevTime.GetSeconds ())) << "\n";
   prevTime = curTime;
   prev = itr->second.txBytes;
-  Simulator::Schedule (Seconds (0.2), &TraceThroughput, monitor);
 }
 
 // Check the queue size
-void CheckQueueSize (Ptr<QueueDisc> qd)
+void CheckQueueSize (Ptr<QueueDisc> qd, std::ostream &q)
 {
   uint32_t qsize = qd->GetCurrentSize ().GetValue ();
-  Simulator::Schedule (Seconds (0.2), &CheckQueueSize, qd);
-  std::ofstream q (dir + "/queueSize.dat", std::ios::out | std::ios::app);
-  q << Simulator::Now ().GetSeconds () << " " << qsize << std::endl;
-  q.close ();
+  q << Simulator::Now ().GetSeconds () << " " << qsize << "\n";
 }
 
 // Trace congestion window
@@ -121,12 +118,14 @@ int main (int argc, char *argv [])
   bool bql = true;
   bool enablePcap = false;
   Time stopTime = Seconds (100);
+  Time sampleInterval = Seconds (0.2);
 
   CommandLine cmd (__FILE__);
   cmd.AddValue ("tcpTypeId", "Transport protocol to use: TcpNewReno, TcpBbr", tcpTypeId);
   cmd.AddValue ("delAckCount", "Delayed ACK count", delAckCount);
   cmd.AddValue ("enablePcap", "Enable/Disable pcap file generation", enablePcap);
   cmd.AddValue ("stopTime", "Stop time for applications / simulation time will be stopTime + 1", stopTime);
+  cmd.AddValue ("sampleInterval", "Interval of the throughput and queue size samples", sampleInterval);
   cmd.Parse (argc, argv);
 
   queueDisc = std::string ("ns3::") + queueDisc;
@@ -235,7 +234,9 @@ int main (int argc, char *argv [])
   tch.Uninstall (routers.Get (0)->GetDevice (1));
   QueueDiscContainer qd;
   qd = tch.Install (routers.Get (0)->GetDevice (1));
-  Simulator::ScheduleNow (&CheckQueueSize, qd.Get (0));
+  PeriodicSampler queueSampler (dir + "/queueSize.dat", sampleInterval,
+                                MakeBoundCallback (&CheckQueueSize, qd.Get (0)));
+  queueSampler.Start (Seconds (0));
 
   // Generate PCAP traces if it is enabled
   if (enablePcap)
@@ -250,10 +251,17 @@ int main (int argc, char *argv [])
   // Check for dropped packets using Flow Monitor
   FlowMonitorHelper flowmon;
   Ptr<FlowMonitor> monitor = flowmon.InstallAll ();
-  Simulator::Schedule (Seconds (0 + 0.000001), &TraceThroughput, monitor);
+  PeriodicSampler throughputSampler (dir + "/throughput.dat", sampleInterval,
+                                     MakeBoundCallback (&TraceThroughput, monitor));
+  throughputSampler.Start (Seconds (0 + 0.000001));
 
   Simulator::Stop (stopTime + TimeStep (1));
   Simulator::Run ();
+
+  // read by CustomBuffer/ScenarioBench
+  std::cout << std::endl << "*** Simulation summary ***" << std::endl;
+  std::cout << "  Events:   " << Simulator::GetEventCount () << std::endl;
+  std::cout << "  Simulated time:   " << Simulator::Now ().GetSeconds () << " s" << std::endl;
   Simulator::Destroy ();
 
   return 0;
@@ -27,11 +27,14 @@
 // - pcap traces also generated in the following files
 //   "tcp-large-transfer-$n-$i.pcap" where n and i represent node and interface
 // numbers respectively
+// - with --capture=ring, only n0's device is captured, headers only, in
+//   "tcp-large-transfer-ring-$k.pcap" around the k-th drop burst
 //  Usage (e.g.): ./ns3 run tcp-large-transfer
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <memory>
 
 #include "ns3/core-module.h"
 #include "ns3/applications-module.h"
@@ -39,6 +42,7 @@
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ring-pcap-capture.h"
 
 using namespace ns3;
 
@@ -75,8 +79,25 @@ int main (int argc, char *argv[])
   //  LogComponentEnable("PacketSink", LOG_LEVEL_ALL);
   //  LogComponentEnable("TcpLargeTransfer", LOG_LEVEL_ALL);
 
+  // "all": full pcap of every device, "ring": snaplen-limited ring on the
+  // bottleneck device written around drop bursts (ring-pcap-capture.h), "none"
+  std::string capture = "all";
+  uint32_t snapLen = 96;
+  uint32_t ringPackets = 4096;
+  uint32_t dropBurst = 10;
+  double dropWindow = 0.01;
+  double postTrigger = 0.1;
+
   CommandLine cmd (__FILE__);
+  cmd.AddValue ("capture", "Packet capture: all, ring, none", capture);
+  cmd.AddValue ("snapLen", "Bytes kept per packet by the ring capture", snapLen);
+  cmd.AddValue ("ringPackets", "Packets kept in memory by the ring capture", ringPackets);
+  cmd.AddValue ("dropBurst", "Drops that trigger the ring capture, 0 for never", dropBurst);
+  cmd.AddValue ("dropWindow", "Time window of a drop burst [s]", dropWindow);
+  cmd.AddValue ("postTrigger", "Capture time after the last trigger [s]", postTrigger);
   cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (capture != "all" && capture != "ring" && capture != "none",
+                   "Unknown capture " << capture);
 
   // initialize the tx buffer.
   for(uint32_t i = 0; i < writeSize; ++i)
@@ -166,14 +187,30 @@ int main (int argc, char *argv[])
   //localSocket->SetAttribute("SndBufSize", UintegerValue(4096));
 
   //Ask for ASCII and pcap traces of network traffic
-  AsciiTraceHelper ascii;
-  p2p.EnableAsciiAll (ascii.CreateFileStream ("tcp-large-transfer.tr"));
-  p2p.EnablePcapAll ("tcp-large-transfer");
+  if (capture == "all")
+    {
+      AsciiTraceHelper ascii;
+      p2p.EnableAsciiAll (ascii.CreateFileStream ("tcp-large-transfer.tr"));
+      p2p.EnablePcapAll ("tcp-large-transfer");
+    }
+  std::unique_ptr<RingPcapCapture> ring;
+  if (capture == "ring")
+    {
+      ring.reset (new RingPcapCapture ("tcp-large-transfer-ring", snapLen, ringPackets));
+      ring->SetDropBurst (dropBurst, Seconds (dropWindow));
+      ring->SetPostTrigger (Seconds (postTrigger));
+      // n0 is where the queue of the flow builds
+      ring->Install (dev0.Get (0));
+    }
 
   // Finally, set up the simulator to run.  The 1000 second hard limit is a
   // failsafe in case some change above causes the simulation to never end
   Simulator::Stop (Seconds (1000));
   Simulator::Run ();
+  if (ring)
+    {
+      std::cout << "Ring capture: " << ring->GetIncidents () << " incident(s) written" << std::endl;
+    }
   Simulator::Destroy ();
 }
 
@@ -32,6 +32,8 @@
 // - pcap traces also generated in the following files
 //   "tcp-star-server-$n-$i.pcap" where n and i represent node and interface
 //   numbers respectively
+// - with --capture=ring, only the device of n1 is captured, headers only, in
+//   "tcp-star-server-ring-$k.pcap" around the k-th drop burst
 // Usage examples for things you might want to tweak:
 //       ./ns3 run="tcp-star-server"
 //       ./ns3 run="tcp-star-server --nNodes=25"
@@ -46,6 +48,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <memory>
 #include <cassert>
 
 #include "ns3/core-module.h"
@@ -54,6 +57,7 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ring-pcap-capture.h"
 
 using namespace ns3;
 
@@ -75,11 +79,28 @@ main (int argc, char *argv[])
   Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue ("5kb/s"));
   uint32_t N = 9; //number of nodes in the star
 
+  // "all": full pcap of every device, "ring": snaplen-limited ring on the
+  // bottleneck device written around drop bursts (ring-pcap-capture.h), "none"
+  std::string capture = "all";
+  uint32_t snapLen = 96;
+  uint32_t ringPackets = 4096;
+  uint32_t dropBurst = 10;
+  double dropWindow = 0.01;
+  double postTrigger = 0.1;
+
   // Allow the user to override any of the defaults and the above
   // Config::SetDefault()s at run-time, via command-line arguments
   CommandLine cmd (__FILE__);
   cmd.AddValue ("nNodes", "Number of nodes to place in the star", N);
+  cmd.AddValue ("capture", "Packet capture: all, ring, none", capture);
+  cmd.AddValue ("snapLen", "Bytes kept per packet by the ring capture", snapLen);
+  cmd.AddValue ("ringPackets", "Packets kept in memory by the ring capture", ringPackets);
+  cmd.AddValue ("dropBurst", "Drops that trigger the ring capture, 0 for never", dropBurst);
+  cmd.AddValue ("dropWindow", "Time window of a drop burst [s]", dropWindow);
+  cmd.AddValue ("postTrigger", "Capture time after the last trigger [s]", postTrigger);
   cmd.Parse (argc, argv);
+  NS_ABORT_MSG_IF (capture != "all" && capture != "ring" && capture != "none",
+                   "Unknown capture " << capture);
 
   // Here, we will create N nodes in a star.
   NS_LOG_INFO ("Create nodes.");
@@ -154,12 +175,28 @@ main (int argc, char *argv[])
 
 
   //configure tracing
-  AsciiTraceHelper ascii;
-  p2p.EnableAsciiAll (ascii.CreateFileStream ("tcp-star-server.tr"));
-  p2p.EnablePcapAll ("tcp-star-server");
+  if (capture == "all")
+    {
+      AsciiTraceHelper ascii;
+      p2p.EnableAsciiAll (ascii.CreateFileStream ("tcp-star-server.tr"));
+      p2p.EnablePcapAll ("tcp-star-server");
+    }
+  std::unique_ptr<RingPcapCapture> ring;
+  if (capture == "ring")
+    {
+      ring.reset (new RingPcapCapture ("tcp-star-server-ring", snapLen, ringPackets));
+      ring->SetDropBurst (dropBurst, Seconds (dropWindow));
+      ring->SetPostTrigger (Seconds (postTrigger));
+      // the clients send to the server, capture where the queue of client 0 builds
+      ring->Install (deviceAdjacencyList[0].Get (1));
+    }
 
   NS_LOG_INFO ("Run Simulation.");
   Simulator::Run ();
+  if (ring)
+    {
+      std::cout << "Ring capture: " << ring->GetIncidents () << " incident(s) written" << std::endl;
+    }
   Simulator::Destroy ();
   NS_LOG_INFO ("Done.");
 
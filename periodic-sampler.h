@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef PERIODIC_SAMPLER_H
+#define PERIODIC_SAMPLER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+/**
+ * \brief Writes one sample line to a file every interval.
+ *
+ * The file is opened once with a large stream buffer and stays open until
+ * the sampler is destroyed, so a sample costs a formatted write into memory
+ * instead of an open/append/close. The callback writes the line (including
+ * the trailing '\n') and should read its counters by reference.
+ *
+ * Header only, so scenarios in scratch/ can include it directly. The sampler
+ * must outlive Simulator::Run (); keep it on the stack of main ().
+ */
+class PeriodicSampler
+{
+public:
+  typedef Callback<void, std::ostream &> SampleCallback;
+
+  PeriodicSampler (const std::string &filename, Time interval, SampleCallback cb,
+                   std::size_t bufferSize = 1 << 20)
+    : m_buffer (bufferSize),
+      m_interval (interval),
+      m_cb (cb)
+  {
+    // the buffer has to be installed before the file is opened
+    m_out.rdbuf ()->pubsetbuf (m_buffer.data (), m_buffer.size ());
+    m_out.open (filename, std::ios::out | std::ios::trunc);
+  }
+
+  ~PeriodicSampler ()
+  {
+    m_out.flush ();
+  }
+
+  void
+  Start (Time at)
+  {
+    m_event = Simulator::Schedule (at, &PeriodicSampler::Sample, this);
+  }
+
+  void
+  Stop (void)
+  {
+    m_event.Cancel ();
+    m_out.flush ();
+  }
+
+private:
+  PeriodicSampler (const PeriodicSampler &);
+  PeriodicSampler &operator= (const PeriodicSampler &);
+
+  void
+  Sample (void)
+  {
+    m_cb (m_out);
+    m_event = Simulator::Schedule (m_interval, &PeriodicSampler::Sample, this);
+  }
+
+  std::vector<char> m_buffer;
+  std::ofstream m_out;
+  Time m_interval;
+  SampleCallback m_cb;
+  EventId m_event;
+};
+
+} // namespace ns3
+
+#endif /* PERIODIC_SAMPLER_H */
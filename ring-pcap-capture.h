@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef RING_PCAP_CAPTURE_H
+#define RING_PCAP_CAPTURE_H
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/abort.h"
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/queue-disc.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-helper.h"
+#include "ns3/traffic-control-layer.h"
+
+namespace ns3 {
+
+/**
+ * \brief Forensic pcap capture of one device around incidents.
+ *
+ * Instead of writing every packet of every device to disk, the packets seen
+ * by the device (the PromiscSniffer trace, both directions, like
+ * EnablePcap) are cut to the snaplen and kept in a fixed-size ring in
+ * memory, overwriting the oldest. Nothing is written until a trigger:
+ * a burst of at least dropBurst drops within dropWindow in the root queue
+ * disc or the device queue of the device, or a call to Trigger (). The ring
+ * is then written, oldest first, to a new file "<prefix>-<n>.pcap",
+ * followed by the packets of the next postTrigger; a trigger during an
+ * incident extends it. Files are written with a large stream buffer.
+ *
+ * Header only, so scenarios in scratch/ can include it directly. Install
+ * after the addresses are assigned (the default root queue disc is
+ * installed then); the capture must outlive Simulator::Run (), keep it in
+ * main (). The ring is allocated by the constructor, so only construct a
+ * capture that is installed.
+ */
+class RingPcapCapture
+{
+public:
+  RingPcapCapture (const std::string &prefix, uint32_t snapLen = 96,
+                   uint32_t ringPackets = 4096, std::size_t bufferSize = 1 << 20,
+                   uint32_t dataLinkType = PcapHelper::DLT_PPP)
+    : m_prefix (prefix),
+      m_snapLen (snapLen),
+      m_slotSize (RECORD_HEADER + snapLen),
+      m_ring (static_cast<std::size_t> (ringPackets) * (RECORD_HEADER + snapLen)),
+      m_nSlots (ringPackets),
+      m_head (0),
+      m_count (0),
+      m_scratch (snapLen),
+      m_buffer (bufferSize),
+      m_dataLinkType (dataLinkType),
+      m_dropBurst (10),
+      m_dropWindow (MilliSeconds (10)),
+      m_postTrigger (MilliSeconds (100)),
+      m_dropIndex (0),
+      m_drops (0),
+      m_maxIncidents (16),
+      m_incidents (0),
+      m_recording (false)
+  {
+    NS_ABORT_MSG_IF (ringPackets == 0 || snapLen == 0, "The ring and the snaplen must not be empty");
+    m_dropTimes.resize (m_dropBurst);
+  }
+
+  ~RingPcapCapture ()
+  {
+    if (m_recording)
+      {
+        m_out.close ();
+      }
+  }
+
+  /// trigger on at least \p drops drops within \p window, 0 drops for manual triggers only
+  void
+  SetDropBurst (uint32_t drops, Time window)
+  {
+    m_dropBurst = drops;
+    m_dropWindow = window;
+    m_dropTimes.assign (std::max (drops, 1u), Time ());
+    m_dropIndex = 0;
+    m_drops = 0;
+  }
+
+  /// how long to keep writing after the last trigger of an incident
+  void
+  SetPostTrigger (Time postTrigger)
+  {
+    m_postTrigger = postTrigger;
+  }
+
+  /// later triggers are ignored, to bound the disk usage
+  void
+  SetMaxIncidents (uint32_t maxIncidents)
+  {
+    m_maxIncidents = maxIncidents;
+  }
+
+  /// capture the packets of \p device and watch its queues for drop bursts
+  void
+  Install (Ptr<NetDevice> device)
+  {
+    bool ok = device->TraceConnectWithoutContext ("PromiscSniffer",
+                                                  MakeCallback (&RingPcapCapture::Sniff, this));
+    NS_ABORT_MSG_IF (!ok, "The device has no PromiscSniffer trace");
+
+    Ptr<TrafficControlLayer> tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+    Ptr<QueueDisc> qd = tc ? tc->GetRootQueueDiscOnDevice (device) : 0;
+    if (qd)
+      {
+        qd->TraceConnectWithoutContext ("Drop", MakeCallback (&RingPcapCapture::QueueDiscDrop, this));
+      }
+    PointerValue txQueue;
+    if (device->GetAttributeFailSafe ("TxQueue", txQueue) && txQueue.GetObject ())
+      {
+        txQueue.GetObject ()->TraceConnectWithoutContext ("Drop",
+                                                          MakeCallback (&RingPcapCapture::DeviceDrop, this));
+      }
+  }
+
+  /// write the ring and the next postTrigger of packets
+  void
+  Trigger (void)
+  {
+    if (m_recording)
+      {
+        m_endEvent.Cancel ();
+        m_endEvent = Simulator::Schedule (m_postTrigger, &RingPcapCapture::EndIncident, this);
+        return;
+      }
+    if (m_maxIncidents != 0 && m_incidents >= m_maxIncidents)
+      {
+        return;
+      }
+
+    std::ostringstream fileName;
+    fileName << m_prefix << "-" << m_incidents++ << ".pcap";
+    // the buffer has to be installed before the file is opened
+    m_out.rdbuf ()->pubsetbuf (m_buffer.data (), m_buffer.size ());
+    m_out.open (fileName.str (), std::ios::out | std::ios::binary | std::ios::trunc);
+    NS_ABORT_MSG_IF (!m_out, "Can not open " << fileName.str ());
+    WriteFileHeader ();
+
+    // the oldest record is m_count slots behind the head
+    uint32_t slot = (m_head + m_nSlots - m_count) % m_nSlots;
+    for (uint32_t i = 0; i < m_count; ++i)
+      {
+        const uint8_t *record = &m_ring[static_cast<std::size_t> (slot) * m_slotSize];
+        uint32_t capLen;
+        std::memcpy (&capLen, record + 8, sizeof (capLen));
+        m_out.write (reinterpret_cast<const char *> (record), RECORD_HEADER + capLen);
+        slot = slot + 1 < m_nSlots ? slot + 1 : 0;
+      }
+    m_count = 0;
+    m_recording = true;
+    m_endEvent = Simulator::Schedule (m_postTrigger, &RingPcapCapture::EndIncident, this);
+  }
+
+  /// \return the number of incident files written
+  uint32_t
+  GetIncidents (void) const
+  {
+    return m_incidents;
+  }
+
+private:
+  RingPcapCapture (const RingPcapCapture &);
+  RingPcapCapture &operator= (const RingPcapCapture &);
+
+  static const uint32_t RECORD_HEADER = 16;   //!< ts_sec, ts_usec, incl_len, orig_len
+
+  void
+  Sniff (Ptr<const Packet> p)
+  {
+    uint32_t origLen = p->GetSize ();
+    uint32_t capLen = std::min (origLen, m_snapLen);
+    uint64_t us = Simulator::Now ().GetMicroSeconds ();
+    uint32_t header[4] = {static_cast<uint32_t> (us / 1000000), static_cast<uint32_t> (us % 1000000),
+                          capLen, origLen};
+    if (m_recording)
+      {
+        p->CopyData (m_scratch.data (), capLen);
+        m_out.write (reinterpret_cast<const char *> (header), RECORD_HEADER);
+        m_out.write (reinterpret_cast<const char *> (m_scratch.data ()), capLen);
+        return;
+      }
+    uint8_t *record = &m_ring[static_cast<std::size_t> (m_head) * m_slotSize];
+    std::memcpy (record, header, RECORD_HEADER);
+    p->CopyData (record + RECORD_HEADER, capLen);
+    m_head = m_head + 1 < m_nSlots ? m_head + 1 : 0;
+    m_count = std::min (m_count + 1, m_nSlots);
+  }
+
+  // the drop trace sinks, only the time of the drop matters
+  void
+  QueueDiscDrop (Ptr<const QueueDiscItem>)
+  {
+    Drop ();
+  }
+
+  void
+  DeviceDrop (Ptr<const Packet>)
+  {
+    Drop ();
+  }
+
+  void
+  Drop (void)
+  {
+    if (m_dropBurst == 0)
+      {
+        return;
+      }
+    // m_dropTimes keeps the last m_dropBurst drops, m_dropIndex points to the oldest
+    Time now = Simulator::Now ();
+    m_dropTimes[m_dropIndex] = now;
+    m_dropIndex = m_dropIndex + 1 < m_dropBurst ? m_dropIndex + 1 : 0;
+    ++m_drops;
+    if (m_drops >= m_dropBurst && now - m_dropTimes[m_dropIndex] <= m_dropWindow)
+      {
+        Trigger ();
+      }
+  }
+
+  void
+  EndIncident (void)
+  {
+    m_out.close ();
+    m_recording = false;
+  }
+
+  void
+  WriteFileHeader (void)
+  {
+    // pcap global header in host byte order, readers detect it from the magic
+    uint32_t magic = 0xa1b2c3d4;
+    uint16_t version[2] = {2, 4};
+    int32_t thisZone = 0;
+    uint32_t sigFigs = 0;
+    m_out.write (reinterpret_cast<const char *> (&magic), sizeof (magic));
+    m_out.write (reinterpret_cast<const char *> (version), sizeof (version));
+    m_out.write (reinterpret_cast<const char *> (&thisZone), sizeof (thisZone));
+    m_out.write (reinterpret_cast<const char *> (&sigFigs), sizeof (sigFigs));
+    m_out.write (reinterpret_cast<const char *> (&m_snapLen), sizeof (m_snapLen));
+    m_out.write (reinterpret_cast<const char *> (&m_dataLinkType), sizeof (m_dataLinkType));
+  }
+
+  std::string m_prefix;
+  uint32_t m_snapLen;
+  uint32_t m_slotSize;                 //!< record header and snaplen bytes
+  std::vector<uint8_t> m_ring;         //!< m_nSlots records of m_slotSize bytes
+  uint32_t m_nSlots;
+  uint32_t m_head;                     //!< next slot to write
+  uint32_t m_count;                    //!< records in the ring
+  std::vector<uint8_t> m_scratch;
+  std::vector<char> m_buffer;
+  std::ofstream m_out;
+  uint32_t m_dataLinkType;
+
+  uint32_t m_dropBurst;
+  Time m_dropWindow;
+  Time m_postTrigger;
+  std::vector<Time> m_dropTimes;
+  uint32_t m_dropIndex;
+  uint64_t m_drops;
+
+  uint32_t m_maxIncidents;
+  uint32_t m_incidents;
+  bool m_recording;
+  EventId m_endEvent;
+};
+
+} // namespace ns3
+
+#endif /* RING_PCAP_CAPTURE_H */